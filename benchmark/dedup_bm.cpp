@@ -0,0 +1,58 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include "drl/dedup.h"
+
+
+/**
+ * Deduplication of st.range(0) random documents with identifiers in [0, st.range(1)), with a fixed strategy or the
+ * adaptive choice.
+ */
+auto BM_dedup = [](benchmark::State &st, int _strategy) {
+  std::size_t n = st.range(0), nd = st.range(1);
+
+  std::mt19937 gen(n + nd);
+  std::vector<uint32_t> input(n);
+  for (auto &&d : input) d = gen() % nd;
+
+  std::vector<uint32_t> docs;
+  docs.reserve(n);
+  for (auto _ : st) {
+    docs.assign(input.begin(), input.end());
+    if (_strategy < 0) {
+      drl::Dedup(docs);
+    } else {
+      drl::Dedup(docs, static_cast<drl::DedupStrategy>(_strategy));
+    }
+    benchmark::DoNotOptimize(docs.data());
+  }
+
+  st.counters["Docs"] = docs.size();
+  st.SetItemsProcessed(st.iterations() * n);
+};
+
+
+int main(int argc, char *argv[]) {
+  const std::vector<std::pair<std::string, int>> strategies = {
+      {"Sort", static_cast<int>(drl::DedupStrategy::kSort)},
+      {"Radix", static_cast<int>(drl::DedupStrategy::kRadix)},
+      {"Bitmap", static_cast<int>(drl::DedupStrategy::kBitmap)},
+      {"Adaptive", -1}};
+
+  for (const auto &strategy : strategies) {
+    auto bm = benchmark::RegisterBenchmark(("Dedup-" + strategy.first).c_str(), BM_dedup, strategy.second);
+    for (int64_t n : {16, 256, 4096, 65536, 1 << 20}) {
+      for (int64_t nd : {1000, 100000, 10000000}) {
+        bm->Args({n, nd});
+      }
+    }
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}
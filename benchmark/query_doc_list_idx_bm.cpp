@@ -3,7 +3,10 @@
 //
 
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 
 #include <boost/filesystem.hpp>
 
@@ -21,10 +24,15 @@
 
 #include "drl/doclist.h"
 #include "drl/pdlrp.h"
+#include "drl/pdlcount.h"
 #include "drl/grammar_index.h"
 #include "drl/pdloda.h"
 #include "drl/sa.h"
 #include "drl/dl_basic_scheme.h"
+#include "drl/rmq.h"
+#include "drl/dl_index.h"
+#include "drl/construct_sada.h"
+#include "drl/dedup.h"
 #include "drl/dl_sampled_tree_scheme.h"
 #include "drl/helper.h"
 #include "drl/pdl_suffix_tree.h"
@@ -35,10 +43,15 @@
 DEFINE_string(data, "", "Collection file.");
 DEFINE_string(patterns, "", "Patterns file.");
 DEFINE_bool(print_size, true, "Print size.");
+DEFINE_bool(mmap, false, "Memory-map the PDL files instead of reading them.");
+DEFINE_bool(mmap_populate, false, "Read the memory-mapped files into memory at load time.");
+DEFINE_int32(rule_cache, 64, "Size in MB of the rule-expansion cache of the PDL-RP variants with cache.");
 
 DEFINE_int32(bs, 512, "Block size.");
 DEFINE_int32(sf, 4, "Storing factor.");
 
+DEFINE_int32(threads, 1, "Number of concurrent query threads (reentrant indices only).");
+
 auto BM_r_index = [](benchmark::State &st,
                      auto *idx,
                      const auto &doc_border_rank,
@@ -59,8 +72,7 @@ auto BM_r_index = [](benchmark::State &st,
         docs.push_back(doc_border_rank(item));
       }
 
-      sort(docs.begin(), docs.end());
-      docs.erase(unique(docs.begin(), docs.end()), docs.end());
+      drl::Dedup(docs);
 
       docc += docs.size();
     }
@@ -89,8 +101,7 @@ auto BM_dl_brute_da = [](benchmark::State &st,
 
       get_docs(range.first, range.second + 1, add_doc);
 
-      sort(docs.begin(), docs.end());
-      docs.erase(unique(docs.begin(), docs.end()), docs.end());
+      drl::Dedup(docs);
 
       docc += docs.size();
     }
@@ -119,6 +130,43 @@ auto BM_dl_scheme =
       if (FLAGS_print_size) st.counters["Size"] = _size_in_bytes;
     };
 
+auto BM_dl_count =
+    [](benchmark::State &st, auto *idx, const auto &rlcsa, const auto &patterns, std::size_t _size_in_bytes = 0) {
+      usint docc = 0;
+
+      for (auto _ : st) {
+        docc = 0;
+        for (const auto &pat : patterns) {
+          auto range = rlcsa->count(pat);
+          docc += idx->count(range.first, range.second + 1);
+        }
+      }
+
+      st.counters["Patterns"] = patterns.size();
+      st.counters["Docs"] = docc;
+      if (FLAGS_print_size) st.counters["Size"] = _size_in_bytes;
+    };
+
+auto BM_count_with_query = [](benchmark::State &st, const auto &idx, const auto &rlcsa, const auto &patterns) {
+  if (!(idx->isOk())) {
+    st.SkipWithError("Cannot initialize index!");
+  }
+
+  usint docc = 0;
+
+  for (auto _ : st) {
+    docc = 0;
+    for (const auto &pat : patterns) {
+      auto range = rlcsa->count(pat);
+      docc += idx->count(range);
+    }
+  }
+
+  st.counters["Patterns"] = patterns.size();
+  st.counters["Docs"] = docc;
+  if (FLAGS_print_size) st.counters["Size"] = idx->reportSize();
+};
+
 auto BM_query_doc_list_without_buffer =
     [](benchmark::State &st, const auto &idx, const auto &rlcsa, const auto &patterns) {
       if (!(idx->isOk())) {
@@ -174,6 +222,80 @@ auto BM_query_doc_list_with_query = [](benchmark::State &st, const auto &idx, co
   if (FLAGS_print_size) st.counters["Size"] = idx->reportSize();
 };
 
+auto BM_query_doc_list_with_query_reuse =
+    [](benchmark::State &st, const auto &idx, const auto &rlcsa, const auto &patterns) {
+      if (!(idx->isOk())) {
+        st.SkipWithError("Cannot initialize index!");
+      }
+
+      usint docc = 0;
+      typename std::decay_t<decltype(*idx)>::result_type res;
+
+      for (auto _ : st) {
+        docc = 0;
+        for (const auto &pat : patterns) {
+          auto range = rlcsa->count(pat);
+
+          if (idx->query(range, res)) {
+            docc += res.size();
+          }
+        }
+      }
+
+      st.counters["Patterns"] = patterns.size();
+      st.counters["Docs"] = docc;
+      if (FLAGS_print_size) st.counters["Size"] = idx->reportSize();
+    };
+
+auto BM_query_doc_list_with_rule_cache =
+    [](benchmark::State &st, const auto &idx, const auto &rlcsa, const auto &patterns) {
+      BM_query_doc_list_with_query_reuse(st, idx, rlcsa, patterns);
+
+      const auto *cache = idx->getRuleCache();
+      if (cache != nullptr) {
+        st.counters["CacheHits"] = cache->hits();
+        st.counters["CacheMisses"] = cache->misses();
+        st.counters["CacheSize"] = cache->size();
+      }
+    };
+
+auto BM_compute_cover = [](benchmark::State &st, const auto &compute_cover, const auto &rlcsa, const auto &patterns) {
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  for (const auto &pat : patterns) {
+    auto range = rlcsa->count(pat);
+    if (!CSA::isEmpty(range)) ranges.emplace_back(range.first, range.second + 1);
+  }
+
+  usint nodes = 0;
+  for (auto _ : st) {
+    nodes = 0;
+    for (const auto &range : ranges) {
+      nodes += compute_cover(range.first, range.second).second.size();
+    }
+  }
+
+  st.counters["Patterns"] = ranges.size();
+  st.counters["Nodes"] = nodes;
+};
+
+auto BM_compute_cover_batch =
+    [](benchmark::State &st, const auto &compute_cover, const auto &rlcsa, const auto &patterns) {
+      std::vector<std::pair<std::size_t, std::size_t>> ranges;
+      for (const auto &pat : patterns) {
+        auto range = rlcsa->count(pat);
+        if (!CSA::isEmpty(range)) ranges.emplace_back(range.first, range.second + 1);
+      }
+
+      std::vector<std::pair<std::size_t, std::size_t>> covered;
+      std::vector<std::size_t> nodes, offsets;
+      for (auto _ : st) {
+        compute_cover.ComputeBatch(ranges, covered, nodes, offsets);
+      }
+
+      st.counters["Patterns"] = ranges.size();
+      st.counters["Nodes"] = nodes.size();
+    };
+
 auto BM_grammar_index = [](benchmark::State &st, auto *idx, const auto &queries) {
   usint docc = 0;
 
@@ -222,12 +344,38 @@ bool Load(_T &_t, const std::string &_prefix, const sdsl::cache_config &_cconfig
 }
 
 
+/**
+ * Check that the values fit in the 32-bit storage of drl::SIMDBlockRMQ, whose constructor throws otherwise.
+ */
+template<typename _Values>
+bool FitsSIMDBlockRMQ(const _Values &_values) {
+  return _values.width() <= 32 || std::all_of(_values.begin(), _values.end(), [](const auto &_value) {
+    return _value <= std::numeric_limits<uint32_t>::max();
+  });
+}
+
+
 template<typename _T>
 bool Save(const _T &_t, const std::string &_prefix, const sdsl::cache_config &_cconfig) {
   return sdsl::store_to_file(_t, sdsl::cache_file_name<_T>(_prefix, _cconfig));
 }
 
 
+/**
+ * Load a self-contained index from the cache.
+ *
+ * @return nullptr if the index is missing or has another version
+ */
+template<typename _Index>
+std::unique_ptr<_Index> LoadIndex(const std::string &_prefix, const sdsl::cache_config &_cconfig) {
+  auto idx = std::make_unique<_Index>();
+  std::ifstream input(sdsl::cache_file_name<_Index>(_prefix, _cconfig), std::ios::binary);
+  if (input && idx->load(input)) return idx;
+
+  return nullptr;
+}
+
+
 class MergeSetsBinTreeFunctor {
  public:
   template<typename _II, typename _Sets, typename _Result>
@@ -265,8 +413,7 @@ class MergeSetsLinearFunctor {
     }
     _sets.addBlocks(*prev, c, report);
 
-    sort(_result.begin(), _result.end());
-    _result.erase(unique(_result.begin(), _result.end()), _result.end());
+    drl::Dedup(_result);
   }
 
 //  template<typename _II, typename _Sets, typename _Result, typename _SetUnion>
@@ -349,22 +496,47 @@ int main(int argc, char *argv[]) {
 
 
 
+  // Reported documents (per query): hash table for small results, epoch stamps otherwise
+  typedef drl::ReportedAdaptiveSet<> Reported;
+
+  // Self-contained indices, loaded first: the DA and the RMQs of the other schemes are those of the indices
+  typedef drl::DLSadakaneIndex<drl::DefaultRMQ, sdsl::int_vector<>, Reported> SadakaneIndexDA;
+  typedef drl::DLILCPIndex<drl::DefaultRMQ, sdsl::int_vector<>, Reported> ILCPIndexDA;
+  auto sada_da_idx = LoadIndex<SadakaneIndexDA>("sada_da_idx", cconfig_sep_0);
+  auto ilcp_da_idx = LoadIndex<ILCPIndexDA>("ilcp_da_idx", cconfig_sep_0);
+
+
+
   // Get document functionalities
   drl::GetDocRLCSA get_doc_rlcsa(rlcsa);
 
   drl::RLCSAWrapper rlcsa_wrapper(*rlcsa, data_path.string());
-  sdsl::int_vector<> da;
-  {
-    std::vector<uint32_t> doc_array;
-    doc_array.reserve(rlcsa_wrapper.size() + 1);
-    rlcsa_wrapper.GetDA(doc_array);
+  if (!sada_da_idx) {
+    std::cout << "Construct SADA-D index" << std::endl;
+
+    sdsl::int_vector<> da;
+    {
+      std::vector<uint32_t> doc_array;
+      doc_array.reserve(rlcsa_wrapper.size() + 1);
+      rlcsa_wrapper.GetDA(doc_array);
+
+      grammar::Construct(da, doc_array);
+      sdsl::util::bit_compress(da);
+    }
 
-    grammar::Construct(da, doc_array);
-    sdsl::util::bit_compress(da);
+    drl::DefaultRMQ rmq;
+    {
+      std::ifstream input(FLAGS_data + ".sada");
+      rmq.load(input);
+    }
+
+    sada_da_idx = std::make_unique<SadakaneIndexDA>(std::move(rmq), std::move(da), kNDocs + 1);
+    Save(*sada_da_idx, "sada_da_idx", cconfig_sep_0);
   }
+  const auto &da = sada_da_idx->store();
   const auto kSize_da = sdsl::size_in_bytes(da);
 
-  drl::GetDocDA<decltype(da)> get_doc_da(da);
+  drl::GetDocDA<const sdsl::int_vector<>> get_doc_da(da);
 //  drl::DefaultGetDocs<decltype(get_doc_da)> get_docs_da(get_doc_da);
 
   grammar::RePairEncoder<true> encoder;
@@ -434,21 +606,90 @@ int main(int argc, char *argv[]) {
   // Sadakane
   //**********
 
-  drl::DefaultRMQ rmq_sada;
-  {
-    std::ifstream input(FLAGS_data + ".sada");
-    rmq_sada.load(input);
-  }
+  const auto &rmq_sada = sada_da_idx->rmq();
   const auto kSize_rmq_sada = sdsl::size_in_bytes(rmq_sada);
 
-  auto sada = drl::BuildDLSadakane<sdsl::bit_vector>(rmq_sada, get_doc_rlcsa, kNDocs + 1);
-  benchmark::RegisterBenchmark("SADA-L", BM_dl_scheme, &sada, rlcsa, patterns, kSize_rmq_sada);
+  auto sada = drl::BuildDLSadakane<Reported>(rmq_sada, get_doc_rlcsa, kNDocs + 1);
+  benchmark::RegisterBenchmark("SADA-L", BM_dl_scheme, &sada, rlcsa, patterns, kSize_rmq_sada)->Threads(FLAGS_threads);
+
+  auto sada_da = drl::BuildDLSadakane<Reported>(rmq_sada, get_doc_da, kNDocs + 1);
+  benchmark::RegisterBenchmark("SADA-D", BM_dl_scheme, &sada_da, rlcsa, patterns, kSize_rmq_sada + kSize_da)
+      ->Threads(FLAGS_threads);
+
+  auto sada_gcda = drl::BuildDLSadakane<Reported>(rmq_sada, get_doc_gcda, kNDocs + 1);
+  benchmark::RegisterBenchmark("SADA-C", BM_dl_scheme, &sada_gcda, rlcsa, patterns, kSize_rmq_sada + kSize_slp)
+      ->Threads(FLAGS_threads);
+
+  // Self-contained index: RMQ, DA and number of documents in a single file
+  benchmark::RegisterBenchmark("SADA-D-IDX", BM_dl_scheme, sada_da_idx.get(), rlcsa, patterns,
+                               sdsl::size_in_bytes(*sada_da_idx))->Threads(FLAGS_threads);
+
+  // Block RMQs on the C array: bit-compressed with scalar scans (BRMQ) and 32-bit values with SIMD scans (SRMQ)
+  // The values of the C array are at most the length of the DA, so the SRMQ variants are skipped beforehand when the
+  // DA is longer than 32 bits.
+  drl::CompactBlockRMQ brmq_sada;
+  drl::SIMDBlockRMQ srmq_sada;
+  const bool has_srmq_sada = da.size() <= std::numeric_limits<uint32_t>::max();
+  if (!has_srmq_sada) std::cout << "The C array does not fit in 32 bits: SADA-*-SRMQ are skipped" << std::endl;
+
+  bool has_brmq_sada = Load(brmq_sada, "sada_brmq", cconfig_sep_0);
+  bool build_srmq_sada = has_srmq_sada && !Load(srmq_sada, "sada_srmq", cconfig_sep_0);
+  if (!has_brmq_sada || build_srmq_sada) {
+    std::cout << "Construct Block RMQs (SADA)" << std::endl;
+
+    sdsl::int_vector<> c_array;
+    drl::ConstructCArray(da, kNDocs + 1, c_array);
+
+    if (!has_brmq_sada) {
+      brmq_sada = drl::CompactBlockRMQ(&c_array);
+      Save(brmq_sada, "sada_brmq", cconfig_sep_0);
+    }
+    if (build_srmq_sada) {
+      srmq_sada = drl::SIMDBlockRMQ(&c_array);
+      Save(srmq_sada, "sada_srmq", cconfig_sep_0);
+    }
+  }
+  const auto kSize_brmq_sada = sdsl::size_in_bytes(brmq_sada);
+  const auto kSize_srmq_sada = sdsl::size_in_bytes(srmq_sada);
 
-  auto sada_da = drl::BuildDLSadakane<sdsl::bit_vector>(rmq_sada, get_doc_da, kNDocs + 1);
-  benchmark::RegisterBenchmark("SADA-D", BM_dl_scheme, &sada_da, rlcsa, patterns, kSize_rmq_sada + kSize_da);
+  auto sada_brmq = drl::BuildDLSadakane<Reported>(brmq_sada, get_doc_rlcsa, kNDocs + 1);
+  benchmark::RegisterBenchmark("SADA-L-BRMQ", BM_dl_scheme, &sada_brmq, rlcsa, patterns, kSize_brmq_sada)
+      ->Threads(FLAGS_threads);
 
-  auto sada_gcda = drl::BuildDLSadakane<sdsl::bit_vector>(rmq_sada, get_doc_gcda, kNDocs + 1);
-  benchmark::RegisterBenchmark("SADA-C", BM_dl_scheme, &sada_gcda, rlcsa, patterns, kSize_rmq_sada + kSize_slp);
+  auto sada_da_brmq = drl::BuildDLSadakane<Reported>(brmq_sada, get_doc_da, kNDocs + 1);
+  benchmark::RegisterBenchmark("SADA-D-BRMQ", BM_dl_scheme, &sada_da_brmq, rlcsa, patterns, kSize_brmq_sada + kSize_da)
+      ->Threads(FLAGS_threads);
+
+  auto sada_srmq = drl::BuildDLSadakane<Reported>(srmq_sada, get_doc_rlcsa, kNDocs + 1);
+  auto sada_da_srmq = drl::BuildDLSadakane<Reported>(srmq_sada, get_doc_da, kNDocs + 1);
+  if (has_srmq_sada) {
+    benchmark::RegisterBenchmark("SADA-L-SRMQ", BM_dl_scheme, &sada_srmq, rlcsa, patterns, kSize_srmq_sada)
+        ->Threads(FLAGS_threads);
+
+    benchmark::RegisterBenchmark("SADA-D-SRMQ", BM_dl_scheme, &sada_da_srmq, rlcsa, patterns, kSize_srmq_sada + kSize_da)
+        ->Threads(FLAGS_threads);
+  }
+
+  // Counting: Sadakane's document counter (built by DoclistSada), or listing without materializing the result
+  std::shared_ptr<drl::DocCounter> doc_counter;
+  {
+    std::ifstream input(FLAGS_data + Doclist::COUNTER_EXTENSION, std::ios::binary);
+    if (input) {
+      doc_counter = std::make_shared<drl::DocCounter>();
+      doc_counter->load(input);
+    }
+  }
+  const auto kSize_doc_counter = doc_counter ? sdsl::size_in_bytes(*doc_counter) : 0;
+
+  benchmark::RegisterBenchmark("SADA-Count-L", BM_dl_count, &sada, rlcsa, patterns, kSize_rmq_sada)
+      ->Threads(FLAGS_threads);
+
+  auto sada_count = drl::BuildDLSadakane<Reported>(rmq_sada, get_doc_rlcsa, kNDocs + 1);
+  sada_count.setCounter(doc_counter);
+  if (doc_counter) {
+    benchmark::RegisterBenchmark("SADA-Count", BM_dl_count, &sada_count, rlcsa, patterns, kSize_doc_counter)
+        ->Threads(FLAGS_threads);
+  }
 
 
 
@@ -456,24 +697,81 @@ int main(int argc, char *argv[]) {
   // ILCP
   //******
 
-  drl::DefaultRMQ rmq_ilcp;
-  std::shared_ptr<CSA::DeltaVector> run_heads_ilcp;
-  {
-    std::ifstream input(FLAGS_data + ".ilcp");
-    rmq_ilcp.load(input);
+  if (!ilcp_da_idx) {
+    std::cout << "Construct ILCP-D index" << std::endl;
+
+    drl::DefaultRMQ rmq;
+    std::shared_ptr<CSA::DeltaVector> run_heads;
+    {
+      std::ifstream input(FLAGS_data + ".ilcp");
+      rmq.load(input);
+
+      run_heads.reset(new CSA::DeltaVector(input));
+    }
 
-    run_heads_ilcp.reset(new CSA::DeltaVector(input));
+    // The index owns its DA, so this is the only copy
+    ilcp_da_idx = std::make_unique<ILCPIndexDA>(std::move(rmq), std::move(run_heads), da, kNDocs + 1);
+    Save(*ilcp_da_idx, "ilcp_da_idx", cconfig_sep_0);
   }
+  const auto &rmq_ilcp = ilcp_da_idx->rmq();
+  const auto &run_heads_ilcp = ilcp_da_idx->runHeads();
   const auto kSize_rmq_ilcp = sdsl::size_in_bytes(rmq_ilcp) + run_heads_ilcp->reportSize();
 
-  auto ilcp = drl::BuildDLILCP<sdsl::bit_vector>(rmq_ilcp, run_heads_ilcp, get_doc_rlcsa, kNDocs + 1, get_doc_rlcsa);
-  benchmark::RegisterBenchmark("ILCP-L", BM_dl_scheme, &ilcp, rlcsa, patterns, kSize_rmq_ilcp);
+  auto ilcp = drl::BuildDLILCP<Reported>(rmq_ilcp, run_heads_ilcp, get_doc_rlcsa, kNDocs + 1, get_doc_rlcsa);
+  benchmark::RegisterBenchmark("ILCP-L", BM_dl_scheme, &ilcp, rlcsa, patterns, kSize_rmq_ilcp)->Threads(FLAGS_threads);
+
+  auto ilcp_da = drl::BuildDLILCP<Reported>(rmq_ilcp, run_heads_ilcp, get_doc_da, kNDocs + 1, get_doc_da);
+  benchmark::RegisterBenchmark("ILCP-D", BM_dl_scheme, &ilcp_da, rlcsa, patterns, kSize_rmq_ilcp + kSize_da)
+      ->Threads(FLAGS_threads);
+
+  auto ilcp_gcda = drl::BuildDLILCP<Reported>(rmq_ilcp, run_heads_ilcp, get_doc_gcda, kNDocs + 1, get_doc_gcda);
+  benchmark::RegisterBenchmark("ILCP-C", BM_dl_scheme, &ilcp_gcda, rlcsa, patterns, kSize_rmq_ilcp + kSize_slp)
+      ->Threads(FLAGS_threads);
+
+  // Self-contained index: RMQ, run heads, DA and number of documents in a single file
+  benchmark::RegisterBenchmark("ILCP-D-IDX", BM_dl_scheme, ilcp_da_idx.get(), rlcsa, patterns,
+                               sdsl::size_in_bytes(*ilcp_da_idx))->Threads(FLAGS_threads);
+
+  // Block RMQs on the ILCP run heads (the SRMQ variants are skipped when they do not fit in 32 bits)
+  drl::CompactBlockRMQ brmq_ilcp;
+  drl::SIMDBlockRMQ srmq_ilcp;
+  bool has_srmq_ilcp = Load(srmq_ilcp, "ilcp_srmq", cconfig_sep_0);
+  if (!Load(brmq_ilcp, "ilcp_brmq", cconfig_sep_0) || !has_srmq_ilcp) {
+    std::cout << "Construct Block RMQs (ILCP)" << std::endl;
 
-  auto ilcp_da = drl::BuildDLILCP<sdsl::bit_vector>(rmq_ilcp, run_heads_ilcp, get_doc_da, kNDocs + 1, get_doc_da);
-  benchmark::RegisterBenchmark("ILCP-D", BM_dl_scheme, &ilcp_da, rlcsa, patterns, kSize_rmq_ilcp + kSize_da);
+    auto heads = DoclistILCP::buildRunHeads(*rlcsa);
+
+    brmq_ilcp = drl::CompactBlockRMQ(&heads);
+    Save(brmq_ilcp, "ilcp_brmq", cconfig_sep_0);
+
+    has_srmq_ilcp = FitsSIMDBlockRMQ(heads);
+    if (has_srmq_ilcp) {
+      srmq_ilcp = drl::SIMDBlockRMQ(&heads);
+      Save(srmq_ilcp, "ilcp_srmq", cconfig_sep_0);
+    } else {
+      std::cout << "The run heads do not fit in 32 bits: ILCP-*-SRMQ are skipped" << std::endl;
+    }
+  }
+  const auto kSize_brmq_ilcp = sdsl::size_in_bytes(brmq_ilcp) + run_heads_ilcp->reportSize();
+  const auto kSize_srmq_ilcp = sdsl::size_in_bytes(srmq_ilcp) + run_heads_ilcp->reportSize();
 
-  auto ilcp_gcda = drl::BuildDLILCP<sdsl::bit_vector>(rmq_ilcp, run_heads_ilcp, get_doc_gcda, kNDocs + 1, get_doc_gcda);
-  benchmark::RegisterBenchmark("ILCP-C", BM_dl_scheme, &ilcp_gcda, rlcsa, patterns, kSize_rmq_ilcp + kSize_slp);
+  auto ilcp_brmq = drl::BuildDLILCP<Reported>(brmq_ilcp, run_heads_ilcp, get_doc_rlcsa, kNDocs + 1, get_doc_rlcsa);
+  benchmark::RegisterBenchmark("ILCP-L-BRMQ", BM_dl_scheme, &ilcp_brmq, rlcsa, patterns, kSize_brmq_ilcp)
+      ->Threads(FLAGS_threads);
+
+  auto ilcp_da_brmq = drl::BuildDLILCP<Reported>(brmq_ilcp, run_heads_ilcp, get_doc_da, kNDocs + 1, get_doc_da);
+  benchmark::RegisterBenchmark("ILCP-D-BRMQ", BM_dl_scheme, &ilcp_da_brmq, rlcsa, patterns, kSize_brmq_ilcp + kSize_da)
+      ->Threads(FLAGS_threads);
+
+  auto ilcp_srmq = drl::BuildDLILCP<Reported>(srmq_ilcp, run_heads_ilcp, get_doc_rlcsa, kNDocs + 1, get_doc_rlcsa);
+  auto ilcp_da_srmq = drl::BuildDLILCP<Reported>(srmq_ilcp, run_heads_ilcp, get_doc_da, kNDocs + 1, get_doc_da);
+  if (has_srmq_ilcp) {
+    benchmark::RegisterBenchmark("ILCP-L-SRMQ", BM_dl_scheme, &ilcp_srmq, rlcsa, patterns, kSize_srmq_ilcp)
+        ->Threads(FLAGS_threads);
+
+    benchmark::RegisterBenchmark("ILCP-D-SRMQ", BM_dl_scheme, &ilcp_da_srmq, rlcsa, patterns, kSize_srmq_ilcp + kSize_da)
+        ->Threads(FLAGS_threads);
+  }
 
 
 
@@ -569,14 +867,17 @@ int main(int argc, char *argv[]) {
   std::shared_ptr<PDLTree> pdl_tree_bc;
   std::shared_ptr<drl::PDLBC<PDLTree>> get_docs_pdl_bc;
   {
-    std::ifstream input(FLAGS_data + ".rlcsa.docs", std::ios::binary);
+    std::string file_name = FLAGS_data + ".rlcsa.docs";
+    std::ifstream input(file_name, std::ios::binary);
+    auto mapped = FLAGS_mmap ? std::make_shared<drl::MappedFile>(file_name, FLAGS_mmap_populate) : nullptr;
+    if (mapped) mapped->adviseRandom();
 
     usint flags = 0;
     input.read((char *) (&flags), sizeof(flags));
 
-    pdl_tree_bc.reset(new PDLTree(*rlcsa, input));
+    pdl_tree_bc.reset(new PDLTree(*rlcsa, input, false, mapped));
 
-    get_docs_pdl_bc = std::make_shared<drl::PDLBC<PDLTree>>(*pdl_tree_bc, input, flags);
+    get_docs_pdl_bc = std::make_shared<drl::PDLBC<PDLTree>>(*pdl_tree_bc, input, flags, mapped);
   }
   const auto kSize_pdl_tree_bc = pdl_tree_bc->reportSize();
   const auto kSize_pdl_bc = kSize_pdl_tree_bc + get_docs_pdl_bc->reportSize();
@@ -598,28 +899,63 @@ int main(int argc, char *argv[]) {
   std::shared_ptr<CSA::ReadBuffer> pdl_grammar_rp;
   std::shared_ptr<CSA::MultiArray> pdl_blocks_rp;
   {
-    std::ifstream input(FLAGS_data + ".pdlrp", std::ios::binary);
+    std::string file_name = FLAGS_data + ".pdlrp";
+    std::ifstream input(file_name, std::ios::binary);
+    auto mapped = FLAGS_mmap ? std::make_shared<drl::MappedFile>(file_name, FLAGS_mmap_populate) : nullptr;
+    if (mapped) mapped->adviseRandom();
 
-    pdl_tree_rp.reset(new PDLTree(*rlcsa, input));
+    pdl_tree_rp.reset(new PDLTree(*rlcsa, input, false, mapped));
 
     pair_type temp;
     input.read((char *) &temp, sizeof(temp)); // Items, bits.
-    pdl_grammar_rp.reset(new CSA::ReadBuffer(input, temp.first, temp.second));
+    pdl_grammar_rp.reset(drl::LoadReadBuffer(input, mapped, temp.first, temp.second));
     pdl_blocks_rp.reset(CSA::MultiArray::readFrom(input));
   }
   const auto kSize_pdl_tree = pdl_tree_rp->reportSize();
   const auto kSize_pdl_rp = kSize_pdl_tree + pdl_grammar_rp->reportSize() + pdl_blocks_rp->reportSize();
 
   auto compute_cover_st_rp = drl::BuildComputeCoverSuffixTreeFunctor(*pdl_tree_rp);
+  benchmark::RegisterBenchmark("PDL-RP-Cover", BM_compute_cover, compute_cover_st_rp, rlcsa, patterns);
+  benchmark::RegisterBenchmark("PDL-RP-Cover-Batch", BM_compute_cover_batch, compute_cover_st_rp, rlcsa, patterns);
   auto get_docs_pdl_rp = drl::BuildGetDocsSuffixTreeRP(*pdl_tree_rp, *pdl_blocks_rp, *pdl_grammar_rp);
 
   //BM
-  benchmark::RegisterBenchmark("PDL-RP", BM_query_doc_list_with_query,
-                               std::make_shared<PDLRP>(*rlcsa, FLAGS_data, false), rlcsa, patterns);
+  auto pdl_rp = std::make_shared<PDLRP>(*rlcsa, FLAGS_data, false, false, false, FLAGS_mmap, FLAGS_mmap_populate);
+  benchmark::RegisterBenchmark("PDL-RP", BM_query_doc_list_with_query, pdl_rp, rlcsa, patterns);
+  benchmark::RegisterBenchmark("PDL-RP-R", BM_query_doc_list_with_query_reuse, pdl_rp, rlcsa, patterns);
+
+  auto pdl_rp_fast = std::make_shared<PDLRP>(*rlcsa, FLAGS_data, false, false, true);
+  benchmark::RegisterBenchmark("PDL-RP-F", BM_query_doc_list_with_query_reuse, pdl_rp_fast, rlcsa, patterns);
+
+  auto pdl_rp_cache = std::make_shared<PDLRP>(*rlcsa, FLAGS_data, false, false, false, FLAGS_mmap, FLAGS_mmap_populate,
+                                              static_cast<usint>(FLAGS_rule_cache) * CSA::MEGABYTE);
+  benchmark::RegisterBenchmark("PDL-RP-RC", BM_query_doc_list_with_rule_cache, pdl_rp_cache, rlcsa, patterns);
+
+  auto load_or_build_pdl_count = [&](bool _fast_count) {
+    auto idx = std::make_shared<PDLCount>(*rlcsa, FLAGS_data, _fast_count);
+    if (!idx->isOk()) {
+      std::cout << "Construct " << (_fast_count ? "PDL-fast" : "PDL-count") << std::endl;
+      idx = std::make_shared<PDLCount>(*rlcsa, static_cast<usint>(FLAGS_bs), _fast_count);
+      idx->writeTo(FLAGS_data);
+    }
+    return idx;
+  };
+
+  auto pdl_count = load_or_build_pdl_count(false);
+  benchmark::RegisterBenchmark("PDL-count", BM_count_with_query, pdl_count, rlcsa, patterns);
+
+  auto pdl_fc = load_or_build_pdl_count(true);
+  benchmark::RegisterBenchmark("PDL-fast", BM_count_with_query, pdl_fc, rlcsa, patterns);
 
   auto dl_pdl_rp_l = drl::BuildDLSampledTreeScheme(compute_cover_st_rp, get_doc_rlcsa, get_docs_pdl_rp, merge_linear);
   benchmark::RegisterBenchmark("PDL-RP-L", BM_dl_scheme, &dl_pdl_rp_l, rlcsa, patterns, kSize_pdl_rp);
 
+  drl::RuleCache rule_cache_rp(static_cast<std::size_t>(FLAGS_rule_cache) * CSA::MEGABYTE);
+  auto get_docs_pdl_rp_rc = drl::BuildGetDocsSuffixTreeRP(*pdl_tree_rp, *pdl_blocks_rp, *pdl_grammar_rp, &rule_cache_rp);
+  auto dl_pdl_rp_l_rc =
+      drl::BuildDLSampledTreeScheme(compute_cover_st_rp, get_doc_rlcsa, get_docs_pdl_rp_rc, merge_linear);
+  benchmark::RegisterBenchmark("PDL-RP-L-RC", BM_dl_scheme, &dl_pdl_rp_l_rc, rlcsa, patterns, kSize_pdl_rp);
+
   auto dl_pdl_rp_c =
       drl::BuildDLSampledTreeScheme(compute_cover_st_rp, lslp_bslp_get_docs, get_docs_pdl_rp, merge_linear);
   benchmark::RegisterBenchmark("PDL-RP-C", BM_dl_scheme, &dl_pdl_rp_c, rlcsa, patterns, kSize_pdl_rp + kSize_lslp_bslp);
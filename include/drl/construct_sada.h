@@ -0,0 +1,194 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_CONSTRUCT_SADA_H
+#define DRL_CONSTRUCT_SADA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <sdsl/int_vector.hpp>
+
+namespace drl {
+
+/**
+ * Resolve the occurrences with a previous occurrence in the chunk [_bp, _ep) of the suffix array.
+ *
+ * _prev maps each document to its last occurrence in the chunk (position relative to _bp, plus one), or 0.
+ * The first occurrences (relative position, document) and the last ones (document, relative position + 1) are appended
+ * to _firsts and _lasts.
+ */
+template<typename _GetDocs, typename _Prev>
+void ConstructCArrayChunk(std::size_t _bp,
+                          std::size_t _ep,
+                          const _GetDocs &_get_docs,
+                          _Prev &_prev,
+                          sdsl::int_vector<> &_c_array,
+                          std::size_t _block_size,
+                          std::vector<std::pair<uint32_t, uint32_t>> &_firsts,
+                          std::vector<std::pair<uint32_t, uint32_t>> &_lasts) {
+  std::vector<uint32_t> docs;
+  docs.reserve(std::min(_block_size, _ep - _bp));
+  for (auto i = _bp; i < _ep; i += _block_size) {
+    docs.clear();
+    _get_docs(i, std::min(i + _block_size, _ep), docs);
+
+    for (std::size_t j = 0; j < docs.size(); ++j) {
+      auto d = docs[j];
+      auto rel = static_cast<uint32_t>(i + j - _bp);
+      auto &prev = _prev[d];
+      if (prev == 0) {
+        _firsts.emplace_back(rel, d);
+      } else {
+        _c_array[i + j] = _bp + prev;
+      }
+      prev = rel + 1;
+    }
+  }
+
+  _lasts.reserve(_firsts.size());
+  for (const auto &item : _firsts) {
+    _lasts.emplace_back(item.second, _prev[item.second]);
+  }
+}
+
+
+/**
+ * Construct Sadakane's C array: C[i] = j + 1, where j < i is the previous position with DA[j] = DA[i], or 0 if there is
+ * no such position.
+ *
+ * The array is computed in parallel on chunks of the suffix array. Each thread reads the documents of its chunk in
+ * blocks of _block_size and resolves the occurrences with a previous occurrence in the chunk. Then a sequential pass
+ * over the chunks resolves the first occurrence of each document in a chunk with the last occurrence in the previous
+ * chunks. The C array is bit-compressed from the start (C[i] <= i), and the chunks are aligned to 64 entries so the
+ * threads never write the same word.
+ *
+ * The positions inside a chunk are stored relative to it in 32 bits. The last occurrences in a chunk are kept in a
+ * dense array of _nd entries only if it is not larger than the chunk, and in a hash table otherwise, so the working
+ * memory of the threads is bounded by the size of their chunks instead of growing as threads * _nd.
+ *
+ * @param _n Size of the suffix array
+ * @param _nd Upper bound on the document identifiers (exclusive)
+ * @param _get_docs Get documents functor: (first, last, result), appending DA[first, last) to the result
+ * @param[out] _c_array C array
+ * @param _block_size Documents retrieved at once by each thread
+ */
+template<typename _GetDocs>
+void ConstructCArray(std::size_t _n,
+                     std::size_t _nd,
+                     const _GetDocs &_get_docs,
+                     sdsl::int_vector<> &_c_array,
+                     std::size_t _block_size = 1u << 20) {
+  _c_array = sdsl::int_vector<>(_n, 0, sdsl::bits::hi(std::max<std::size_t>(_n, 1)) + 1);
+  if (_n == 0) return;
+
+  std::size_t n_chunks = 1;
+#ifdef _OPENMP
+  n_chunks = std::max(omp_get_max_threads(), 1);
+#endif
+  // Chunk-relative positions (plus one) must fit in 32 bits
+  const std::size_t kMaxChunkSize = std::numeric_limits<uint32_t>::max() / 64 * 64;
+  auto chunk_size = std::min(((_n + n_chunks - 1) / n_chunks + 63) / 64 * 64, kMaxChunkSize);
+  n_chunks = (_n + chunk_size - 1) / chunk_size;
+
+  // First occurrences in each chunk, and last occurrence of each document in the chunk (relative positions)
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> firsts(n_chunks);
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> lasts(n_chunks);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (std::size_t c = 0; c < n_chunks; ++c) {
+    auto bp = c * chunk_size, ep = std::min(bp + chunk_size, _n);
+
+    if (_nd <= ep - bp) {
+      std::vector<uint32_t> prev(_nd, 0);
+      ConstructCArrayChunk(bp, ep, _get_docs, prev, _c_array, _block_size, firsts[c], lasts[c]);
+    } else {
+      std::unordered_map<uint32_t, uint32_t> prev;
+      ConstructCArrayChunk(bp, ep, _get_docs, prev, _c_array, _block_size, firsts[c], lasts[c]);
+    }
+  }
+
+  // Fix-up: the first occurrences in a chunk refer to the previous chunks
+  std::vector<std::size_t> prev(_nd, 0);
+  for (std::size_t c = 0; c < n_chunks; ++c) {
+    auto bp = c * chunk_size;
+    for (const auto &item : firsts[c]) {
+      _c_array[bp + item.first] = prev[item.second];
+    }
+    std::vector<std::pair<uint32_t, uint32_t>>().swap(firsts[c]);
+
+    for (const auto &item : lasts[c]) {
+      prev[item.first] = bp + item.second;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>>().swap(lasts[c]);
+  }
+}
+
+
+/**
+ * Construct Sadakane's C array from a document array.
+ */
+template<typename _DocArray>
+void ConstructCArray(const _DocArray &_doc_array, std::size_t _nd, sdsl::int_vector<> &_c_array) {
+  auto get_docs = [&_doc_array](std::size_t _first, std::size_t _last, auto &_result) {
+    for (auto i = _first; i < _last; ++i) {
+      _result.emplace_back(_doc_array[i]);
+    }
+  };
+
+  ConstructCArray(_doc_array.size(), _nd, get_docs, _c_array);
+}
+
+
+/**
+ * Construct Sadakane's C array from a CSA wrapper (e.g., CSAWrapper), computing the documents with the suffix array.
+ */
+template<typename _CSAWrapper>
+void ConstructCArrayFromCSA(const _CSAWrapper &_csa, std::size_t _nd, sdsl::int_vector<> &_c_array) {
+  auto get_docs = [&_csa](std::size_t _first, std::size_t _last, auto &_result) {
+    _csa.GetDocs(_first, _last, _result);
+  };
+
+  ConstructCArray(_csa.size(), _nd, get_docs, _c_array);
+}
+
+
+/**
+ * Construct the RMQ of Sadakane's document listing on the C array of a document array.
+ *
+ * The bit-compressed C array is freed before returning, so the peak memory is the C array plus the RMQ (after the
+ * working memory of ConstructCArray, bounded by the chunk sizes, is released).
+ */
+template<typename _RMQ, typename _DocArray>
+void ConstructSadakaneRMQ(const _DocArray &_doc_array, std::size_t _nd, _RMQ &_rmq) {
+  sdsl::int_vector<> c_array;
+  ConstructCArray(_doc_array, _nd, c_array);
+
+  _rmq = _RMQ(&c_array);
+}
+
+
+/**
+ * Construct the RMQ of Sadakane's document listing on the C array of a CSA wrapper.
+ */
+template<typename _RMQ, typename _CSAWrapper>
+void ConstructSadakaneRMQFromCSA(const _CSAWrapper &_csa, std::size_t _nd, _RMQ &_rmq) {
+  sdsl::int_vector<> c_array;
+  ConstructCArrayFromCSA(_csa, _nd, c_array);
+
+  _rmq = _RMQ(&c_array);
+}
+
+}
+
+#endif //DRL_CONSTRUCT_SADA_H
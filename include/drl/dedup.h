@@ -0,0 +1,157 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_DEDUP_H
+#define DRL_DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace drl {
+
+/// Strategies to deduplicate a list of documents
+enum class DedupStrategy {
+  kSort,   // Comparison sort and unique, for short lists
+  kRadix,  // LSD radix sort on 8-bit digits and unique, for long lists of sparse identifiers
+  kBitmap  // Scan of a bitmap on the identifiers, for long lists of dense identifiers
+};
+
+/// Lists up to this size are sorted with a comparison sort
+const std::size_t kDedupSmallSize = 256;
+
+
+/**
+ * Choose the strategy to deduplicate _n documents with identifiers up to _max.
+ *
+ * The bitmap takes O(_n + _max / 64) time and the radix sort O(_n) per digit of _max, so the bitmap is used when the
+ * identifiers are dense with respect to the number of documents. Scanning a word of the bitmap costs about four times
+ * as much as moving a document in a radix pass, as the random updates miss the cache once the bitmap is large (see
+ * benchmark/dedup_bm.cpp).
+ */
+inline DedupStrategy ChooseDedupStrategy(std::size_t _n, uint64_t _max) {
+  if (_n <= kDedupSmallSize) return DedupStrategy::kSort;
+
+  std::size_t digits = 1;
+  while (digits < 8 && (_max >> (8 * digits)) != 0) ++digits;
+
+  return (4 * (_max / 64) <= digits * _n) ? DedupStrategy::kBitmap : DedupStrategy::kRadix;
+}
+
+
+/// Per-thread buffers of the deduplication, reused between calls. The bitmap is always empty between calls.
+template<typename _Value>
+struct DedupBuffers {
+  std::vector<uint64_t> bitmap;
+  std::vector<_Value> values;
+
+  static DedupBuffers &Get() {
+    static thread_local DedupBuffers buffers;
+    return buffers;
+  }
+};
+
+
+template<typename _Docs>
+void DedupSort(_Docs &_docs) {
+  std::sort(_docs.begin(), _docs.end());
+  _docs.erase(std::unique(_docs.begin(), _docs.end()), _docs.end());
+}
+
+
+template<typename _Docs>
+void DedupRadix(_Docs &_docs, uint64_t _max) {
+  typedef typename _Docs::value_type Value;
+  auto &values = DedupBuffers<Value>::Get().values;
+  values.resize(_docs.size());
+
+  Value *src = &_docs[0], *dst = values.data();
+  for (std::size_t shift = 0; shift < 64 && (_max >> shift) != 0; shift += 8) {
+    std::size_t counts[257] = {0};
+    for (std::size_t i = 0; i < _docs.size(); ++i) {
+      ++counts[((src[i] >> shift) & 0xff) + 1];
+    }
+    for (std::size_t d = 1; d < 257; ++d) counts[d] += counts[d - 1];
+    for (std::size_t i = 0; i < _docs.size(); ++i) {
+      dst[counts[(src[i] >> shift) & 0xff]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+
+  // Unique, moving the sorted values back to the documents if needed
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < _docs.size(); ++i) {
+    if (n == 0 || src[i] != _docs[n - 1]) _docs[n++] = src[i];
+  }
+  _docs.resize(n);
+}
+
+
+template<typename _Docs>
+void DedupBitmap(_Docs &_docs, uint64_t _max) {
+  auto &bitmap = DedupBuffers<typename _Docs::value_type>::Get().bitmap;
+  std::size_t n_words = _max / 64 + 1;
+  if (bitmap.size() < n_words) bitmap.resize(n_words, 0);
+
+  for (const auto &d : _docs) {
+    bitmap[d / 64] |= uint64_t(1) << (d % 64);
+  }
+
+  std::size_t n = 0;
+  for (std::size_t w = 0; w < n_words; ++w) {
+    for (auto word = bitmap[w]; word != 0; word &= word - 1) {
+      _docs[n++] = w * 64 + __builtin_ctzll(word);
+    }
+    bitmap[w] = 0;
+  }
+  _docs.resize(n);
+}
+
+
+/**
+ * Sort the documents and remove the duplicates with the given strategy.
+ *
+ * @tparam _Docs Random access container of unsigned identifiers with resize (e.g., std::vector<uint32_t>)
+ */
+template<typename _Docs>
+void Dedup(_Docs &_docs, DedupStrategy _strategy) {
+  if (_docs.size() <= 1) return;
+
+  if (_strategy == DedupStrategy::kSort) {
+    DedupSort(_docs);
+    return;
+  }
+
+  uint64_t max = *std::max_element(_docs.begin(), _docs.end());
+  if (_strategy == DedupStrategy::kRadix) {
+    DedupRadix(_docs, max);
+  } else {
+    DedupBitmap(_docs, max);
+  }
+}
+
+
+/**
+ * Sort the documents and remove the duplicates, choosing the strategy by the number of documents and the largest
+ * identifier (see ChooseDedupStrategy).
+ */
+template<typename _Docs>
+void Dedup(_Docs &_docs) {
+  if (_docs.size() <= kDedupSmallSize) {
+    Dedup(_docs, DedupStrategy::kSort);
+    return;
+  }
+
+  uint64_t max = *std::max_element(_docs.begin(), _docs.end());
+  if (ChooseDedupStrategy(_docs.size(), max) == DedupStrategy::kBitmap) {
+    DedupBitmap(_docs, max);
+  } else {
+    DedupRadix(_docs, max);
+  }
+}
+
+}
+
+#endif //DRL_DEDUP_H
@@ -9,154 +9,367 @@
 #include <cstdint>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <algorithm>
+#include <numeric>
 
 #include <sdsl/rmq_support.hpp>
 #include <rlcsa/rlcsa.h>
 
+#include "rmq.h"
+#include "query_context.h"
+#include "sink.h"
+#include "doc_counter.h"
+
 namespace drl {
 
+/**
+ * Get the documents of the given positions.
+ *
+ * Uses the batch method GetDocs(positions, docs, args...) of the get document functor, if it has one; otherwise,
+ * it resolves one position at a time.
+ */
+template<typename _GetDoc, typename _Positions, typename _Docs, typename ..._Args>
+auto GetDocsAt(const _GetDoc &_get_doc, const _Positions &_positions, _Docs &_docs, int, _Args &... _args)
+-> decltype(_get_doc.GetDocs(_positions, _docs, _args...), void()) {
+  _get_doc.GetDocs(_positions, _docs, _args...);
+}
+
+template<typename _GetDoc, typename _Positions, typename _Docs, typename ..._Args>
+void GetDocsAt(const _GetDoc &_get_doc, const _Positions &_positions, _Docs &_docs, long, _Args &... _args) {
+  _docs.resize(_positions.size());
+  for (std::size_t i = 0; i < _positions.size(); ++i) {
+    _docs[i] = _get_doc(_positions[i], _args...);
+  }
+}
+
+template<typename _GetDoc, typename _Positions, typename _Docs, typename ..._Args>
+void GetDocsAt(const _GetDoc &_get_doc, const _Positions &_positions, _Docs &_docs, _Args &... _args) {
+  GetDocsAt(_get_doc, _positions, _docs, 0, _args...);
+}
+
+
+const std::size_t kRMQSchemeBatchSize = 32;
+
+class NeverStop {
+ public:
+  bool operator()() const {
+    return false;
+  }
+};
+
 /**
  * List the documents in the range [_bp, _ep) using the RMQ-based scheme.
+ *
+ * Non-recursive engine: the pending intervals are kept in an explicit stack (_frontier) and visited in the same
+ * (pre)order as the recursive formulation, so it reports the same documents in the same order. As every pending
+ * interval is visited, the minimum and its document are resolved ahead of time for up to _batch_size pending
+ * intervals at once: first the RMQ data is prefetched for all of them, then the minima are computed, and finally
+ * their documents are retrieved with a single call to _get_docs(positions, docs).
+ *
+ * The listing stops as soon as _stop() returns true after a report.
  */
-template<typename _RMQ, typename _GetDoc, typename _IsReported, typename _Report>
-void ListDocsRMQScheme(std::size_t _bp, std::size_t _ep, const _RMQ &_rmq, _GetDoc &_get_doc,
-                       const _IsReported &_is_reported, _Report &_report) {
+template<typename _RMQ, typename _GetDocs, typename _IsReported, typename _Report, typename _Stop = NeverStop>
+void ListDocsRMQSchemeBatched(std::size_t _bp,
+                              std::size_t _ep,
+                              const _RMQ &_rmq,
+                              _GetDocs &_get_docs,
+                              const _IsReported &_is_reported,
+                              _Report &_report,
+                              RMQFrontier &_frontier,
+                              std::size_t _batch_size = kRMQSchemeBatchSize,
+                              const _Stop &_stop = _Stop()) {
+  static_assert(IsRMQ<_RMQ>::value, "_RMQ must answer rmq(i, j) with a position");
+
   if (_bp >= _ep) return;
 
-  auto k = _rmq(_bp, _ep - 1);
-  auto d = _get_doc(k);
+  auto &intervals = _frontier.intervals;
+  auto &batch = _frontier.batch;
+  auto &positions = _frontier.positions;
+  auto &docs = _frontier.docs;
+
+  intervals.clear();
+  intervals.push_back({_bp, _ep, 0, 0, false});
+
+  auto resolve = [&]() {
+    // Collect unresolved intervals from the top of the stack (bounded scan)
+    batch.clear();
+    auto window = 4 * _batch_size;
+    for (auto i = intervals.size(); 0 < i && batch.size() < _batch_size && 0 < window; --i, --window) {
+      if (!intervals[i - 1].resolved) batch.push_back(i - 1);
+    }
+
+    for (const auto &i : batch) {
+      PrefetchRMQ(_rmq, intervals[i].bp, intervals[i].ep - 1);
+    }
+
+    positions.clear();
+    for (const auto &i : batch) {
+      positions.push_back(_rmq(intervals[i].bp, intervals[i].ep - 1));
+    }
+
+    _get_docs(positions, docs);
 
-  if (!_is_reported(k, d)) {
-    _report(k, d);
-    ListDocsRMQScheme(_bp, k, _rmq, _get_doc, _is_reported, _report);
-    ListDocsRMQScheme(k + 1, _ep, _rmq, _get_doc, _is_reported, _report);
+    for (std::size_t j = 0; j < batch.size(); ++j) {
+      auto &interval = intervals[batch[j]];
+      interval.k = positions[j];
+      interval.d = docs[j];
+      interval.resolved = true;
+    }
+  };
+
+  while (!intervals.empty()) {
+    if (!intervals.back().resolved) resolve();
+
+    auto interval = intervals.back();
+    intervals.pop_back();
+
+    if (_is_reported(interval.k, interval.d)) continue;
+
+    _report(interval.k, interval.d);
+    if (_stop()) return;
+
+    // Right interval first, so the left one is visited first
+    if (interval.k + 1 < interval.ep) intervals.push_back({interval.k + 1, interval.ep, 0, 0, false});
+    if (interval.bp < interval.k) intervals.push_back({interval.bp, interval.k, 0, 0, false});
   }
 }
 
 
-template<typename _RMQ, typename _GetDoc, typename _IsReported, typename _Report, typename _Postprocess, typename _Preprocess>
+/**
+ * List the documents in the range [_bp, _ep) using the RMQ-based scheme.
+ */
+template<typename _RMQ, typename _GetDoc, typename _IsReported, typename _Report>
+void ListDocsRMQScheme(std::size_t _bp, std::size_t _ep, const _RMQ &_rmq, _GetDoc &_get_doc,
+                       const _IsReported &_is_reported, _Report &_report) {
+  RMQFrontier frontier;
+  auto get_docs = [&_get_doc](const auto &_positions, auto &_docs) { GetDocsAt(_get_doc, _positions, _docs); };
+
+  ListDocsRMQSchemeBatched(_bp, _ep, _rmq, get_docs, _is_reported, _report, frontier);
+}
+
+
+/**
+ * Document listing scheme based on RMQ.
+ *
+ * The scheme only keeps references to immutable structures, so a single object can be queried concurrently. The
+ * functors receive the per-query context as their last argument:
+ *   - get document: (k, context) -> d, and optionally GetDocs(positions, docs, context) for batches
+ *   - is reported?: (k, d, context) -> bool
+ *   - report: (k, d, report_doc, context)
+ *   - preprocess: (bp, ep, context), where bp and ep can be modified
+ *   - postprocess: (docs, context)
+ *
+ * Contexts are taken from an internal pool, or can be given explicitly by the caller.
+ */
+template<typename _RMQ, typename _GetDoc, typename _IsReported, typename _Report, typename _Postprocess, typename _Preprocess, typename _Context>
 class DLBasicScheme {
+  static_assert(IsRMQ<_RMQ>::value, "_RMQ must answer rmq(i, j) with a position");
+
  public:
-  DLBasicScheme(const _RMQ &_rmq, const _GetDoc &_get_doc, const _IsReported &_is_reported, _Report &_report,
-                _Postprocess _postprocess, _Preprocess _preprocess)
+  DLBasicScheme(const _RMQ &_rmq,
+                const _GetDoc &_get_doc,
+                const _IsReported &_is_reported,
+                const _Report &_report,
+                std::size_t _nd,
+                _Postprocess _postprocess,
+                _Preprocess _preprocess)
       : rmq_(_rmq), get_doc_{_get_doc}, is_reported_{_is_reported}, report_{_report},
-        postprocess_{_postprocess}, preprocess_{_preprocess} {}
+        postprocess_{_postprocess}, preprocess_{_preprocess}, nd_{_nd}, contexts_{BuildContextPool<_Context>(_nd)} {}
+
+  auto list(std::size_t _bp, std::size_t _ep) const {
+    auto context = contexts_->Acquire();
 
-  auto list(std::size_t _bp, std::size_t _ep) {
+    return list(_bp, _ep, *context);
+  }
+
+  auto list(std::size_t _bp, std::size_t _ep, _Context &_context) const {
     std::vector<uint32_t> docs;
     auto add_doc = [&docs](auto d) { docs.push_back(d); };
 
-    auto &report__ = this->report_;
-    auto report = [&report__, &add_doc](auto _k, auto _d) { report__(_k, _d, add_doc); };
+    list(_bp, _ep, add_doc, kNoLimit, _context);
 
-    preprocess_(_bp, _ep);
+    return docs;
+  }
 
-    ListDocsRMQScheme(_bp, _ep, rmq_, get_doc_, is_reported_, report);
+  /**
+   * List the documents in [_bp, _ep) into a sink (callable or output iterator), stopping after _limit documents.
+   *
+   * @return Number of documents emitted
+   */
+  template<typename _Sink>
+  std::size_t list(std::size_t _bp, std::size_t _ep, _Sink &&_sink, std::size_t _limit = kNoLimit) const {
+    auto context = contexts_->Acquire();
 
-    postprocess_(docs);
+    return list(_bp, _ep, _sink, _limit, *context);
+  }
 
-    return docs;
+  template<typename _Sink>
+  std::size_t list(std::size_t _bp, std::size_t _ep, _Sink &&_sink, std::size_t _limit, _Context &_context) const {
+    typedef ReportedTraits<decltype(_context.reported)> Traits;
+
+    if (_limit == 0) return 0;
+
+    auto sink = BuildLimitedSink(_sink, _limit);
+
+    // Reported documents are kept (in the context) only when they are needed to reset the reported set
+    auto &reported_docs = _context.reported_docs;
+    reported_docs.clear();
+    auto add_doc = [&sink, &reported_docs](auto _d) {
+      sink(_d);
+      if (Traits::kResetWithDocs) reported_docs.push_back(_d);
+    };
+
+    auto get_docs = [this, &_context](const auto &_ks, auto &_ds) { GetDocsAt(get_doc_, _ks, _ds, _context); };
+    auto is_reported = [this, &_context](auto _k, auto _d) { return is_reported_(_k, _d, _context); };
+    auto report = [this, &_context, &add_doc](auto _k, auto _d) { report_(_k, _d, add_doc, _context); };
+
+    // The query reports at most min(nd, ep - bp) documents
+    Traits::Prepare(_context.reported, std::min(nd_, _bp < _ep ? _ep - _bp : 0));
+
+    preprocess_(_bp, _ep, _context);
+
+    auto stop = [&sink]() { return sink.full(); };
+
+    ListDocsRMQSchemeBatched(
+        _bp, _ep, rmq_, get_docs, is_reported, report, _context.frontier, kRMQSchemeBatchSize, stop);
+
+    postprocess_(reported_docs, _context);
+
+    return sink.count();
+  }
+
+  /**
+   * Number of distinct documents in [_bp, _ep).
+   *
+   * With a document counter (see setCounter), the range must be a suffix tree node (e.g., a pattern range) and the
+   * documents are not listed. Otherwise, they are listed without materializing the result.
+   */
+  std::size_t count(std::size_t _bp, std::size_t _ep) const {
+    if (counter_) return counter_->count(_bp, _ep);
+
+    return list(_bp, _ep, [](auto) {});
+  }
+
+  void setCounter(std::shared_ptr<const DocCounter> _counter) {
+    counter_ = std::move(_counter);
+  }
+
+  auto acquireContext() const {
+    return contexts_->Acquire();
   }
 
  protected:
   const _RMQ &rmq_;
   const _GetDoc &get_doc_;
   const _IsReported &is_reported_;
-  _Report &report_;
+  const _Report &report_;
 
   _Postprocess postprocess_;
   _Preprocess preprocess_;
+
+  std::size_t nd_;
+  std::unique_ptr<ContextPool<_Context>> contexts_;
+
+  std::shared_ptr<const DocCounter> counter_;
 };
 
 
 class DefaultProcess {
  public:
   template<typename ..._Args>
-  void operator()(const _Args &... _args) {}
+  void operator()(const _Args &... _args) const {}
 };
 
 
-template<typename _RMQ, typename _GetDoc, typename _IsReported, typename _Report, typename _Postprocess = DefaultProcess, typename _Preprocess = DefaultProcess>
-auto BuildDLScheme(const _RMQ &_rmq, _GetDoc &_get_doc, const _IsReported &_is_reported, _Report &_report,
-                   _Postprocess _postprocess = DefaultProcess(), _Preprocess _preprocess = DefaultProcess()) {
-  return DLBasicScheme<_RMQ, _GetDoc, _IsReported, _Report, _Postprocess, _Preprocess>(
-      _rmq, _get_doc, _is_reported, _report, _postprocess, _preprocess);
+template<typename _Reported, typename _RMQ, typename _GetDoc, typename _IsReported, typename _Report, typename _Postprocess = DefaultProcess, typename _Preprocess = DefaultProcess>
+auto BuildDLScheme(const _RMQ &_rmq,
+                   const _GetDoc &_get_doc,
+                   const _IsReported &_is_reported,
+                   const _Report &_report,
+                   std::size_t _nd,
+                   _Postprocess _postprocess = DefaultProcess(),
+                   _Preprocess _preprocess = DefaultProcess()) {
+  return DLBasicScheme<_RMQ, _GetDoc, _IsReported, _Report, _Postprocess, _Preprocess, QueryContext<_Reported>>(
+      _rmq, _get_doc, _is_reported, _report, _nd, _postprocess, _preprocess);
 }
 
 
-template<typename _Reported>
 class IsReported {
  public:
-  explicit IsReported(_Reported &_reported) : reported_{_reported} {}
-
-  bool operator()(std::size_t _k, uint32_t _d) const {
-    return reported_[_d];
+  template<typename _Context>
+  bool operator()(std::size_t _k, uint32_t _d, const _Context &_context) const {
+    return ReportedTraits<decltype(_context.reported)>::Test(_context.reported, _d);
   }
-
- private:
-  const _Reported &reported_;
 };
 
 
-template<typename _Reported>
 class PostprocessCleanReported {
  public:
-  explicit PostprocessCleanReported(_Reported &_bitvector) : reported_{_bitvector} {}
-
-  template<typename _Container>
-  void operator()(const _Container &_result) {
-    for (const auto &item: _result) {
-      reported_[item] = 0;
-    }
+  template<typename _Container, typename _Context>
+  void operator()(const _Container &_result, _Context &_context) const {
+    ReportedTraits<decltype(_context.reported)>::Reset(_context.reported, _result);
   }
-
- private:
-  _Reported &reported_;
 };
 
 
-template<typename _Reported>
+template<typename _GetDoc>
 class DLBasicSadakane {
  public:
-  explicit DLBasicSadakane(std::size_t _nd) : reported_{_nd, 0} {}
+  explicit DLBasicSadakane(const _GetDoc &_get_doc) : get_doc_{_get_doc} {}
+
+  /// Get document
+  template<typename _Context>
+  auto operator()(std::size_t _k, _Context &_context) const {
+    return get_doc_(_k);
+  }
+
+  /// Get documents (batch)
+  template<typename _Positions, typename _Docs, typename _Context>
+  void GetDocs(const _Positions &_positions, _Docs &_docs, _Context &_context) const {
+    GetDocsAt(get_doc_, _positions, _docs);
+  }
 
   /// Is reported?
-  bool operator()(std::size_t _k, uint32_t _d) const {
-    return reported_[_d];
+  template<typename _Context>
+  bool operator()(std::size_t _k, uint32_t _d, const _Context &_context) const {
+    return ReportedTraits<decltype(_context.reported)>::Test(_context.reported, _d);
   }
 
   /// Report documents
-  template<typename _Report>
-  void operator()(std::size_t _k, uint32_t _d, _Report &_report_doc) {
+  template<typename _Report, typename _Context>
+  void operator()(std::size_t _k, uint32_t _d, _Report &_report_doc, _Context &_context) const {
     _report_doc(_d);
 
-    reported_[_d] = 1;
+    ReportedTraits<decltype(_context.reported)>::Set(_context.reported, _d);
   };
 
  protected:
-  _Reported reported_;
+  const _GetDoc &get_doc_;
 };
 
 
 template<typename _RMQ, typename _GetDoc, typename _Reported>
 class DLSadakane
-    : public DLBasicSadakane<_Reported>,
+    : public DLBasicSadakane<_GetDoc>,
       public DLBasicScheme<_RMQ,
-                           _GetDoc,
-                           DLBasicSadakane<_Reported>,
-                           DLBasicSadakane<_Reported>,
-                           PostprocessCleanReported<_Reported>,
-                           DefaultProcess> {
+                           DLBasicSadakane<_GetDoc>,
+                           DLBasicSadakane<_GetDoc>,
+                           DLBasicSadakane<_GetDoc>,
+                           PostprocessCleanReported,
+                           DefaultProcess,
+                           QueryContext<_Reported>> {
  public:
   DLSadakane(const _RMQ &_rmq, const _GetDoc &_get_doc, std::size_t _nd)
-      : DLBasicSadakane<_Reported>{_nd},
+      : DLBasicSadakane<_GetDoc>{_get_doc},
         DLBasicScheme<_RMQ,
-                      _GetDoc,
-                      DLBasicSadakane<_Reported>,
-                      DLBasicSadakane<_Reported>,
-                      PostprocessCleanReported<_Reported>,
-                      DefaultProcess>{_rmq, _get_doc, *this, *this,
-                                      PostprocessCleanReported<_Reported>{this->reported_}, DefaultProcess{}} {}
+                      DLBasicSadakane<_GetDoc>,
+                      DLBasicSadakane<_GetDoc>,
+                      DLBasicSadakane<_GetDoc>,
+                      PostprocessCleanReported,
+                      DefaultProcess,
+                      QueryContext<_Reported>>{_rmq, *this, *this, *this, _nd,
+                                               PostprocessCleanReported{}, DefaultProcess{}} {}
 };
 
 
@@ -166,49 +379,60 @@ auto BuildDLSadakane(const _RMQ &_rmq, const _GetDoc &_get_doc, std::size_t _nd)
 }
 
 
-template<typename _GetDoc, typename _Reported, typename _GetDocs>
+template<typename _GetDoc, typename _GetDocs>
 class DLBasicILCP {
  public:
-  DLBasicILCP(std::shared_ptr<CSA::DeltaVector> _run_heads, _GetDoc &_get_doc, std::size_t _nd, _GetDocs &_get_docs)
-      : run_heads_{std::move(_run_heads)}, get_doc_{_get_doc}, reported_{_nd, 0}, get_docs_{_get_docs} {}
+  DLBasicILCP(std::shared_ptr<CSA::DeltaVector> _run_heads, const _GetDoc &_get_doc, const _GetDocs &_get_docs)
+      : run_heads_{std::move(_run_heads)}, get_doc_{_get_doc}, get_docs_{_get_docs} {}
 
   /// Get document
-  auto operator()(std::size_t _k) const {
+  template<typename _Context>
+  auto operator()(std::size_t _k, _Context &_context) const {
     CSA::DeltaVector::Iterator iter(*run_heads_);
 
-    auto b = std::max(sp_, static_cast<decltype(sp_)>(iter.select(_k)));
+    auto b = std::max(_context.sp, static_cast<std::size_t>(iter.select(_k)));
     return get_doc_(b);
   }
 
+  /// Get documents (batch)
+  template<typename _Positions, typename _Docs, typename _Context>
+  void GetDocs(const _Positions &_positions, _Docs &_docs, _Context &_context) const {
+    CSA::DeltaVector::Iterator iter(*run_heads_);
+
+    auto &sa_positions = _context.frontier.sa_positions;
+    sa_positions.resize(_positions.size());
+    for (std::size_t i = 0; i < _positions.size(); ++i) {
+      sa_positions[i] = std::max(_context.sp, static_cast<std::size_t>(iter.select(_positions[i])));
+    }
+
+    GetDocsAt(get_doc_, sa_positions, _docs);
+  }
+
   /// Is reported?
-  bool operator()(std::size_t _k, uint32_t _d) const {
-    return reported_[_d];
+  template<typename _Context>
+  bool operator()(std::size_t _k, uint32_t _d, const _Context &_context) const {
+    return ReportedTraits<decltype(_context.reported)>::Test(_context.reported, _d);
   }
 
   /// Report documents
-  template<typename _Report>
-  void operator()(std::size_t _k, uint32_t _d, _Report &_report_doc) {
-    auto report = [&_report_doc, this](auto __d) {
+  template<typename _Report, typename _Context>
+  void operator()(std::size_t _k, uint32_t _d, _Report &_report_doc, _Context &_context) const {
+    auto report = [&_report_doc, &_context](auto __d) {
       _report_doc(__d);
-      reported_[__d] = 1;
+      ReportedTraits<decltype(_context.reported)>::Set(_context.reported, __d);
     };
 
     report(_d);
 
     CSA::DeltaVector::Iterator iter(*run_heads_);
 
-    auto b = std::max(sp_, static_cast<decltype(sp_)>(iter.select(_k))) + 1;
-    auto e = std::min(ep_, static_cast<decltype(ep_)>(iter.selectNext()));
+    auto b = std::max(_context.sp, static_cast<std::size_t>(iter.select(_k))) + 1;
+    auto e = std::min(_context.ep, static_cast<std::size_t>(iter.selectNext()));
     if (b >= e) return;
 
     get_docs_(b, e, report);
   }
 
-  void setInitialRange(std::size_t _sp, std::size_t _ep) {
-    sp_ = _sp;
-    ep_ = _ep;
-  }
-
   const auto &getRunHeads() const {
     return run_heads_;
   }
@@ -216,23 +440,19 @@ class DLBasicILCP {
  protected:
   std::shared_ptr<CSA::DeltaVector> run_heads_;
   const _GetDoc &get_doc_;
-
-  _Reported reported_;
-
-  _GetDocs &get_docs_;
-
-  std::size_t sp_ = 0;
-  std::size_t ep_ = 0;
+  const _GetDocs &get_docs_;
 };
 
 
 template<typename _DLBasicILCP>
 class PreprocessILCP {
  public:
-  explicit PreprocessILCP(_DLBasicILCP &_get_docs_ilcp) : get_docs_ilcp_{_get_docs_ilcp} {}
+  explicit PreprocessILCP(const _DLBasicILCP &_get_docs_ilcp) : get_docs_ilcp_{_get_docs_ilcp} {}
 
-  void operator()(std::size_t &_sp, std::size_t &_ep) {
-    get_docs_ilcp_.setInitialRange(_sp, _ep);
+  template<typename _Context>
+  void operator()(std::size_t &_sp, std::size_t &_ep, _Context &_context) const {
+    _context.sp = _sp;
+    _context.ep = _ep;
 
     CSA::DeltaVector::Iterator iter(*get_docs_ilcp_.getRunHeads());
     _sp = iter.rank(_sp) - 1;
@@ -240,57 +460,108 @@ class PreprocessILCP {
   }
 
  private:
-  _DLBasicILCP &get_docs_ilcp_;
+  const _DLBasicILCP &get_docs_ilcp_;
 };
 
 
 template<typename _RMQ, typename _GetDoc, typename _Reported, typename _GetDocs>
 class DLILCP
-    : public DLBasicILCP<_GetDoc, _Reported, _GetDocs>,
+    : public DLBasicILCP<_GetDoc, _GetDocs>,
       public DLBasicScheme<_RMQ,
-                           DLBasicILCP<_GetDoc, _Reported, _GetDocs>,
-                           DLBasicILCP<_GetDoc, _Reported, _GetDocs>,
-                           DLBasicILCP<_GetDoc, _Reported, _GetDocs>,
-                           PostprocessCleanReported<_Reported>,
-                           PreprocessILCP<DLBasicILCP<_GetDoc, _Reported, _GetDocs>>> {
+                           DLBasicILCP<_GetDoc, _GetDocs>,
+                           DLBasicILCP<_GetDoc, _GetDocs>,
+                           DLBasicILCP<_GetDoc, _GetDocs>,
+                           PostprocessCleanReported,
+                           PreprocessILCP<DLBasicILCP<_GetDoc, _GetDocs>>,
+                           QueryContext<_Reported>> {
  public:
   DLILCP(const _RMQ &_rmq,
          const std::shared_ptr<CSA::DeltaVector> &_run_heads,
-         _GetDoc &_get_doc,
+         const _GetDoc &_get_doc,
          std::size_t _nd,
-         _GetDocs &_get_docs)
-      : DLBasicILCP<_GetDoc, _Reported, _GetDocs>{_run_heads, _get_doc, _nd, _get_docs},
+         const _GetDocs &_get_docs)
+      : DLBasicILCP<_GetDoc, _GetDocs>{_run_heads, _get_doc, _get_docs},
         DLBasicScheme<_RMQ,
-                      DLBasicILCP<_GetDoc, _Reported, _GetDocs>,
-                      DLBasicILCP<_GetDoc, _Reported, _GetDocs>,
-                      DLBasicILCP<_GetDoc, _Reported, _GetDocs>,
-                      PostprocessCleanReported<_Reported>,
-                      PreprocessILCP<DLBasicILCP<_GetDoc, _Reported, _GetDocs>>>{
-            _rmq, *this, *this, *this, PostprocessCleanReported<_Reported>{this->reported_},
-            PreprocessILCP<DLBasicILCP<_GetDoc, _Reported, _GetDocs>>{*this}} {}
+                      DLBasicILCP<_GetDoc, _GetDocs>,
+                      DLBasicILCP<_GetDoc, _GetDocs>,
+                      DLBasicILCP<_GetDoc, _GetDocs>,
+                      PostprocessCleanReported,
+                      PreprocessILCP<DLBasicILCP<_GetDoc, _GetDocs>>,
+                      QueryContext<_Reported>>{
+            _rmq, *this, *this, *this, _nd, PostprocessCleanReported{},
+            PreprocessILCP<DLBasicILCP<_GetDoc, _GetDocs>>{*this}} {}
 };
 
 
 template<typename _Reported, typename _RMQ, typename _GetDoc, typename _GetDocs>
 auto BuildDLILCP(const _RMQ &_rmq,
                  const std::shared_ptr<CSA::DeltaVector> &_run_heads,
-                 _GetDoc &_get_doc,
+                 const _GetDoc &_get_doc,
                  std::size_t _nd,
-                 _GetDocs &_get_docs) {
+                 const _GetDocs &_get_docs) {
   return DLILCP<_RMQ, _GetDoc, _Reported, _GetDocs>{_rmq, _run_heads, _get_doc, _nd, _get_docs};
 }
 
-typedef sdsl::rmq_succinct_sct<true, sdsl::bp_support_sada<256, 32, sdsl::rank_support_v5<>>> DefaultRMQ;
-
-
 class GetDocRLCSA {
  public:
-  explicit GetDocRLCSA(std::shared_ptr<CSA::RLCSA> _rlcsa) : rlcsa_{std::move(_rlcsa)} {}
+  /**
+   * @param _rlcsa RLCSA
+   * @param _max_gap Maximum gap between consecutive (sorted) positions located together in a batch
+   */
+  explicit GetDocRLCSA(std::shared_ptr<CSA::RLCSA> _rlcsa, std::size_t _max_gap = 8)
+      : rlcsa_{std::move(_rlcsa)}, max_gap_{_max_gap} {}
 
   auto operator()(std::size_t _k) const {
     return rlcsa_->getSequenceForPosition(rlcsa_->locate(_k));
   }
 
+  /**
+   * Get the documents of a batch of positions.
+   *
+   * The positions are sorted and grouped when they are close to each other; each group is located with a single
+   * range locate, which shares the LF/psi walks towards the samples among its positions. Then, all the text positions
+   * are mapped to documents in one call.
+   */
+  template<typename _Positions, typename _Docs>
+  void GetDocs(const _Positions &_positions, _Docs &_docs) const {
+    auto n = _positions.size();
+    _docs.resize(n);
+    if (n == 0) return;
+
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&_positions](auto _a, auto _b) { return _positions[_a] < _positions[_b]; });
+
+    std::vector<usint> values(n);
+    std::vector<usint> buffer;
+    for (std::size_t i = 0; i < n;) {
+      std::size_t b = _positions[order[i]], e = b;
+
+      auto j = i + 1;
+      for (; j < n && _positions[order[j]] <= e + max_gap_; ++j) {
+        e = _positions[order[j]];
+      }
+
+      if (b == e) {
+        auto value = rlcsa_->locate(b);
+        for (; i < j; ++i) values[order[i]] = value;
+        continue;
+      }
+
+      pair_type range(b, e);
+      buffer.resize(CSA::length(range));
+      rlcsa_->locate(range, buffer.data());
+
+      for (; i < j; ++i) {
+        values[order[i]] = buffer[_positions[order[i]] - b];
+      }
+    }
+
+    rlcsa_->getSequenceForPosition(values.data(), n);
+
+    std::copy(values.begin(), values.end(), _docs.begin());
+  }
+
   template<typename _Report>
   void operator()(std::size_t _b, std::size_t _e, _Report &_report) const {
     pair_type range(_b, _e - 1);
@@ -307,6 +578,7 @@ class GetDocRLCSA {
 
  private:
   std::shared_ptr<CSA::RLCSA> rlcsa_;
+  std::size_t max_gap_;
 };
 
 
@@ -0,0 +1,269 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_DL_INDEX_H
+#define DRL_DL_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/io.hpp>
+
+#include "dl_basic_scheme.h"
+
+namespace drl {
+
+/// File header of the self-contained indices: magic ("DRLIDX"), version and index type
+const uint64_t kDLIndexMagic = 0x5844494c5244ull;
+const uint32_t kDLIndexVersion = 1;
+
+enum DLIndexType : uint32_t {
+  kDLIndexSadakane = 1,
+  kDLIndexILCP = 2
+};
+
+inline std::size_t WriteDLIndexHeader(std::ostream &out, DLIndexType _type, sdsl::structure_tree_node *v) {
+  std::size_t written_bytes = 0;
+  written_bytes += sdsl::write_member(kDLIndexMagic, out, v, "magic");
+  written_bytes += sdsl::write_member(kDLIndexVersion, out, v, "version");
+  written_bytes += sdsl::write_member(static_cast<uint32_t>(_type), out, v, "type");
+
+  return written_bytes;
+}
+
+/// Read the header and check that the file has the expected index type and version
+inline bool ReadDLIndexHeader(std::istream &in, DLIndexType _type) {
+  uint64_t magic = 0;
+  uint32_t version = 0, type = 0;
+  sdsl::read_member(magic, in);
+  sdsl::read_member(version, in);
+  sdsl::read_member(type, in);
+
+  return in && magic == kDLIndexMagic && version == kDLIndexVersion && type == _type;
+}
+
+
+/**
+ * Self-contained Sadakane's document listing index: RMQ on the C array, document access backend (e.g., DA or GCDA)
+ * and number of documents, stored in a single versioned file that is loaded with one sequential read.
+ *
+ * @tparam _RMQ RMQ on the C array
+ * @tparam _DocStore Serializable document access backend (e.g., sdsl::int_vector<> for the DA, or a grammar::SLP<>)
+ * @tparam _Reported Set of reported documents
+ * @tparam _GetDoc Get document functor built on the backend (e.g., GetDocDA or GetDocGCDA)
+ */
+template<typename _RMQ, typename _DocStore, typename _Reported, template<typename> class _GetDoc = GetDocDA>
+class DLSadakaneIndex {
+ public:
+  typedef std::size_t size_type;
+  typedef _GetDoc<_DocStore> GetDoc;
+  typedef DLSadakane<_RMQ, GetDoc, _Reported> Scheme;
+
+  DLSadakaneIndex() = default;
+
+  DLSadakaneIndex(_RMQ _rmq, _DocStore _store, std::size_t _nd)
+      : rmq_(std::move(_rmq)), store_(std::move(_store)), nd_{_nd} {
+    scheme_ = std::make_unique<Scheme>(rmq_, get_doc_, nd_);
+  }
+
+  // The scheme refers to the members
+  DLSadakaneIndex(const DLSadakaneIndex &) = delete;
+  DLSadakaneIndex &operator=(const DLSadakaneIndex &) = delete;
+
+  template<typename ..._Args>
+  auto list(_Args &&... _args) const {
+    return scheme_->list(std::forward<_Args>(_args)...);
+  }
+
+  auto count(std::size_t _bp, std::size_t _ep) const {
+    return scheme_->count(_bp, _ep);
+  }
+
+  const Scheme &scheme() const {
+    return *scheme_;
+  }
+
+  const _RMQ &rmq() const {
+    return rmq_;
+  }
+
+  const _DocStore &store() const {
+    return store_;
+  }
+
+  size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, const std::string &name = "") const {
+    auto child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+
+    size_type written_bytes = WriteDLIndexHeader(out, kDLIndexSadakane, child);
+    written_bytes += sdsl::write_member(static_cast<uint64_t>(nd_), out, child, "nd");
+    written_bytes += sdsl::serialize(rmq_, out, child, "rmq");
+    written_bytes += sdsl::serialize(store_, out, child, "docs");
+
+    sdsl::structure_tree::add_size(child, written_bytes);
+
+    return written_bytes;
+  }
+
+  /**
+   * Load the index.
+   *
+   * @return false if the file is not a Sadakane's index of the current version
+   */
+  bool load(std::istream &in) {
+    if (!ReadDLIndexHeader(in, kDLIndexSadakane)) return false;
+
+    uint64_t nd = 0;
+    sdsl::read_member(nd, in);
+    nd_ = nd;
+    sdsl::load(rmq_, in);
+    sdsl::load(store_, in);
+
+    scheme_ = std::make_unique<Scheme>(rmq_, get_doc_, nd_);
+
+    return true;
+  }
+
+ private:
+  _RMQ rmq_;
+  _DocStore store_;
+  GetDoc get_doc_{store_};
+  std::size_t nd_ = 0;
+
+  std::unique_ptr<Scheme> scheme_;
+};
+
+
+/**
+ * Self-contained ILCP document listing index: RMQ on the run heads of the ILCP array, starting positions of the runs,
+ * document access backend and number of documents, stored in a single versioned file.
+ *
+ * The run heads are stored as bit-compressed gaps and the delta vector is rebuilt on load.
+ *
+ * @tparam _RMQ RMQ on the run heads
+ * @tparam _DocStore Serializable document access backend (e.g., sdsl::int_vector<> for the DA, or a grammar::SLP<>)
+ * @tparam _Reported Set of reported documents
+ * @tparam _GetDoc Get document functor built on the backend, used for single documents and ranges
+ */
+template<typename _RMQ, typename _DocStore, typename _Reported, template<typename> class _GetDoc = GetDocDA>
+class DLILCPIndex {
+ public:
+  typedef std::size_t size_type;
+  typedef _GetDoc<_DocStore> GetDoc;
+  typedef DLILCP<_RMQ, GetDoc, _Reported, GetDoc> Scheme;
+
+  DLILCPIndex() = default;
+
+  DLILCPIndex(_RMQ _rmq, std::shared_ptr<CSA::DeltaVector> _run_heads, _DocStore _store, std::size_t _nd)
+      : rmq_(std::move(_rmq)), run_heads_{std::move(_run_heads)}, store_(std::move(_store)), nd_{_nd} {
+    scheme_ = std::make_unique<Scheme>(rmq_, run_heads_, get_doc_, nd_, get_doc_);
+  }
+
+  // The scheme refers to the members
+  DLILCPIndex(const DLILCPIndex &) = delete;
+  DLILCPIndex &operator=(const DLILCPIndex &) = delete;
+
+  template<typename ..._Args>
+  auto list(_Args &&... _args) const {
+    return scheme_->list(std::forward<_Args>(_args)...);
+  }
+
+  auto count(std::size_t _bp, std::size_t _ep) const {
+    return scheme_->count(_bp, _ep);
+  }
+
+  const Scheme &scheme() const {
+    return *scheme_;
+  }
+
+  const _RMQ &rmq() const {
+    return rmq_;
+  }
+
+  const _DocStore &store() const {
+    return store_;
+  }
+
+  const std::shared_ptr<CSA::DeltaVector> &runHeads() const {
+    return run_heads_;
+  }
+
+  size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, const std::string &name = "") const {
+    auto child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+
+    // Gaps between the starting positions of the runs
+    sdsl::int_vector<> gaps(run_heads_->getNumberOfItems(), 0, 64);
+    {
+      CSA::DeltaVector::Iterator iter(*run_heads_);
+      std::size_t prev = 0;
+      for (std::size_t i = 0; i < gaps.size(); ++i) {
+        std::size_t pos = (i == 0) ? iter.select(0) : iter.selectNext();
+        gaps[i] = pos - prev;
+        prev = pos;
+      }
+      sdsl::util::bit_compress(gaps);
+    }
+
+    size_type written_bytes = WriteDLIndexHeader(out, kDLIndexILCP, child);
+    written_bytes += sdsl::write_member(static_cast<uint64_t>(nd_), out, child, "nd");
+    written_bytes += sdsl::serialize(rmq_, out, child, "rmq");
+    written_bytes += sdsl::write_member(static_cast<uint64_t>(run_heads_->getSize()), out, child, "n");
+    written_bytes += sdsl::serialize(gaps, out, child, "run_heads");
+    written_bytes += sdsl::serialize(store_, out, child, "docs");
+
+    sdsl::structure_tree::add_size(child, written_bytes);
+
+    return written_bytes;
+  }
+
+  /**
+   * Load the index.
+   *
+   * @return false if the file is not an ILCP index of the current version
+   */
+  bool load(std::istream &in) {
+    if (!ReadDLIndexHeader(in, kDLIndexILCP)) return false;
+
+    uint64_t nd = 0, n = 0;
+    sdsl::read_member(nd, in);
+    nd_ = nd;
+    sdsl::load(rmq_, in);
+    sdsl::read_member(n, in);
+    {
+      sdsl::int_vector<> gaps;
+      sdsl::load(gaps, in);
+
+      CSA::DeltaVector::Encoder encoder(kRunHeadsBlockSize);
+      std::size_t pos = 0;
+      for (const auto &gap : gaps) {
+        pos += gap;
+        encoder.setBit(pos);
+      }
+      run_heads_ = std::make_shared<CSA::DeltaVector>(encoder, n);
+    }
+    sdsl::load(store_, in);
+
+    scheme_ = std::make_unique<Scheme>(rmq_, run_heads_, get_doc_, nd_, get_doc_);
+
+    return true;
+  }
+
+ private:
+  static const std::size_t kRunHeadsBlockSize = 32;
+
+  _RMQ rmq_;
+  std::shared_ptr<CSA::DeltaVector> run_heads_;
+  _DocStore store_;
+  GetDoc get_doc_{store_};
+  std::size_t nd_ = 0;
+
+  std::unique_ptr<Scheme> scheme_;
+};
+
+}
+
+#endif //DRL_DL_INDEX_H
@@ -10,9 +10,63 @@
 #include <vector>
 #include <algorithm>
 
+#include "dedup.h"
+#include "reported_set.h"
+#include "sink.h"
 
 namespace drl {
 
+/**
+ * Report the documents in the set of a node, using addBlocks(node, 1, report) if the sets support it, or iterating
+ * over the container _sets[node] otherwise.
+ */
+template<typename _Sets, typename _Report>
+auto ReportDocSet(const _Sets &_sets, std::size_t _node, _Report &_report, int)
+-> decltype(_sets.addBlocks(_node, 1, _report), void()) {
+  _sets.addBlocks(_node, 1, _report);
+}
+
+template<typename _Sets, typename _Report>
+void ReportDocSet(const _Sets &_sets, std::size_t _node, _Report &_report, long) {
+  for (const auto &d : _sets[_node]) {
+    _report(d);
+  }
+}
+
+template<typename _Sets, typename _Report>
+void ReportDocSet(const _Sets &_sets, std::size_t _node, _Report &_report) {
+  ReportDocSet(_sets, _node, _report, 0);
+}
+
+
+/**
+ * Report the documents in the set of a node until _stop() returns true, using addBlocksUntil(node, 1, report, stop)
+ * if the sets support it. Otherwise, the container _sets[node] is iterated while _stop() returns false.
+ */
+template<typename _Sets, typename _Report, typename _Stop>
+auto ReportDocSetUntil(const _Sets &_sets, std::size_t _node, _Report &_report, const _Stop &_stop, int)
+-> decltype(_sets.addBlocksUntil(_node, 1, _report, _stop), void()) {
+  _sets.addBlocksUntil(_node, 1, _report, _stop);
+}
+
+template<typename _Sets, typename _Report, typename _Stop>
+void ReportDocSetUntil(const _Sets &_sets, std::size_t _node, _Report &_report, const _Stop &_stop, long) {
+  const auto &set = _sets[_node];
+  for (auto it = set.begin(); it != set.end() && !_stop(); ++it) {
+    _report(*it);
+  }
+}
+
+template<typename _Sets, typename _Report, typename _Stop>
+void ReportDocSetUntil(const _Sets &_sets, std::size_t _node, _Report &_report, const _Stop &_stop) {
+  ReportDocSetUntil(_sets, _node, _report, _stop, 0);
+}
+
+
+/// Minimum length of the chunks in which the borders of a limited listing are located
+const std::size_t kMinBorderChunkSize = 64;
+
+
 template<typename _ComputeCover, typename _GetDocs, typename _GetDocSet, typename _MergeSets>
 class DLSampledTreeScheme {
  public:
@@ -44,8 +98,7 @@ class DLSampledTreeScheme {
       get_docs_(range.second, _ep, add_doc);
     }
 
-    sort(docs.begin(), docs.end());
-    docs.erase(unique(docs.begin(), docs.end()), docs.end());
+    Dedup(docs);
 
     if (nodes.empty()) {
       return docs;
@@ -56,6 +109,72 @@ class DLSampledTreeScheme {
     return docs;
   }
 
+  /**
+   * List the documents in [_sp, _ep) into a sink (callable or output iterator), stopping after _limit documents.
+   *
+   * Documents are emitted (without repetitions) as they are found, i.e., unsorted: first the ones in the uncovered
+   * borders of the range, and then the sets of the cover nodes, which are expanded one at a time only while the limit
+   * has not been reached. No full merge of the sets is done. The borders are located in chunks and the sets are
+   * expanded with addBlocksUntil (if supported), so the work stops soon after the limit is reached.
+   *
+   * @return Number of documents emitted
+   */
+  template<typename _Sink>
+  std::size_t list(std::size_t _sp, std::size_t _ep, _Sink &&_sink, std::size_t _limit = kNoLimit) const {
+    if (_sp >= _ep || _limit == 0) return 0;
+
+    auto sink = BuildLimitedSink(_sink, _limit);
+
+    ReportedHashSet seen;
+    seen.Prepare(std::min(std::min(_limit, _ep - _sp), kSeenDocsInitialSize));
+
+    auto add_doc = [&sink, &seen](const auto &_d) {
+      if (sink.full() || seen.Test(_d)) return;
+
+      seen.Set(_d);
+      sink(_d);
+    };
+
+    auto cover = compute_cover_(_sp, _ep);
+
+    const auto &range = cover.first;
+    const auto &nodes = cover.second;
+
+    if (nodes.empty()) {
+      getDocsUntilFull(_sp, _ep, add_doc, sink, _limit);
+      return sink.count();
+    }
+
+    getDocsUntilFull(_sp, range.first, add_doc, sink, _limit);
+    getDocsUntilFull(range.second, _ep, add_doc, sink, _limit);
+
+    auto full = [&sink]() { return sink.full(); };
+    for (auto it = nodes.begin(); it != nodes.end() && !sink.full(); ++it) {
+      ReportDocSetUntil(get_doc_set_, *it, add_doc, full);
+    }
+
+    return sink.count();
+  }
+
+ private:
+  /**
+   * Report the documents in [_b, _e) in chunks of at least the number of documents still missing, until the sink is
+   * full.
+   */
+  template<typename _Report, typename _LimitedSink>
+  void getDocsUntilFull(std::size_t _b,
+                        std::size_t _e,
+                        _Report &_report,
+                        const _LimitedSink &_sink,
+                        std::size_t _limit) const {
+    while (_b < _e && !_sink.full()) {
+      auto chunk = std::max(_limit - _sink.count(), kMinBorderChunkSize);
+      auto e = (_e - _b <= chunk) ? _e : _b + chunk;
+      get_docs_(_b, e, _report);
+      _b = e;
+    }
+  }
+
  protected:
   const _ComputeCover &compute_cover_;
   const _GetDocs &get_docs_;
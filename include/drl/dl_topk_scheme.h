@@ -0,0 +1,205 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_DL_TOPK_SCHEME_H
+#define DRL_DL_TOPK_SCHEME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "sink.h"
+
+namespace drl {
+
+/// Document and its frequency (number of occurrences) in a range
+typedef std::pair<uint32_t, uint32_t> DocFreq;
+
+/// Order of the top-k results: descending by frequency, ascending by id (as sortByFrequency)
+struct DocFreqGreater {
+  bool operator()(const DocFreq &_a, const DocFreq &_b) const {
+    return _a.second > _b.second || (_a.second == _b.second && _a.first < _b.first);
+  }
+};
+
+
+/**
+ * Top-k document retrieval on a sampled tree with frequency-sorted sets (e.g., PDL with mode_topk).
+ *
+ * The range is decomposed into the uncovered borders and a cover of disjoint nodes, so the frequency of a document is
+ * the sum of its frequencies in the borders and in the node sets. When the range is exactly one node, its set is
+ * already sorted by frequency and only the first k documents are expanded. Otherwise, the borders are counted and the
+ * node sets are merged with a threshold algorithm (NRA): their prefixes are read in rounds of doubling length, and the
+ * reading stops once the k best candidates have exact frequencies and no other document (seen or not) can reach the
+ * k-th one. The last frequency read from a node bounds the frequencies of its unread documents.
+ *
+ * Functors:
+ *   - compute cover: (sp, ep) -> ((first, last), nodes), where [first, last) is the covered range
+ *   - get documents: (bp, ep, report), with report(d) for each position in [bp, ep)
+ *   - get document frequencies: (node, limit, report), with report(d, freq) for at most limit documents of the node
+ *     set, in decreasing order of frequency
+ */
+template<typename _ComputeCover, typename _GetDocs, typename _GetDocFreqs>
+class DLTopK {
+ public:
+  DLTopK(const _ComputeCover &_compute_cover, const _GetDocs &_get_docs, const _GetDocFreqs &_get_doc_freqs)
+      : compute_cover_{_compute_cover}, get_docs_{_get_docs}, get_doc_freqs_{_get_doc_freqs} {}
+
+  /**
+   * The _k most frequent documents in [_sp, _ep) with their frequencies, sorted by DocFreqGreater.
+   */
+  auto topk(std::size_t _sp, std::size_t _ep, std::size_t _k) const {
+    std::vector<DocFreq> result;
+    if (_sp >= _ep || _k == 0) return result;
+
+    auto cover = compute_cover_(_sp, _ep);
+
+    const auto &range = cover.first;
+    const auto &nodes = cover.second;
+
+    auto add_doc_freq = [&result](const auto &_d, const auto &_f) { result.emplace_back(_d, _f); };
+
+    if (nodes.size() == 1 && range.first == _sp && range.second == _ep) {
+      result.reserve(std::min(_k, _ep - _sp));
+      get_doc_freqs_(nodes.front(), _k, add_doc_freq);
+      return result;
+    }
+
+    std::unordered_map<uint32_t, uint32_t> border_freqs;
+    auto add_doc = [&border_freqs](const auto &_d) { ++border_freqs[_d]; };
+
+    if (nodes.empty()) {
+      get_docs_(_sp, _ep, add_doc);
+      return selectTopK(border_freqs, _k);
+    }
+
+    get_docs_(_sp, range.first, add_doc);
+    get_docs_(range.second, _ep, add_doc);
+
+    return mergeNodes(nodes, border_freqs, _k);
+  }
+
+ private:
+  /// Prefix of a node set read so far
+  struct NodePrefix {
+    std::size_t node;
+    std::vector<DocFreq> docs;
+    bool exhausted = false;
+  };
+
+  /// Bounds of a candidate: lower is the frequency seen so far, and seen_bound the sum of the bounds of the unexhausted
+  /// nodes where it was seen, so its upper bound is lower + (sum of the bounds of unexhausted nodes) - seen_bound
+  struct Bounds {
+    uint32_t lower = 0;
+    uint64_t seen_bound = 0;
+  };
+
+  template<typename _Nodes>
+  std::vector<DocFreq> mergeNodes(const _Nodes &_nodes,
+                                  const std::unordered_map<uint32_t, uint32_t> &_border_freqs,
+                                  std::size_t _k) const {
+    std::vector<NodePrefix> prefixes(_nodes.size());
+    for (std::size_t i = 0; i < _nodes.size(); ++i) prefixes[i].node = _nodes[i];
+
+    DocFreqGreater greater;
+    std::unordered_map<uint32_t, Bounds> candidates;
+    for (std::size_t limit = _k;; limit = (limit > kNoLimit / 2) ? kNoLimit : 2 * limit) {
+      // Read the next prefixes of the unexhausted nodes
+      uint64_t threshold = 0;
+      for (auto &prefix : prefixes) {
+        if (prefix.exhausted) continue;
+
+        prefix.docs.clear();
+        auto add_doc_freq = [&prefix](const auto &_d, const auto &_f) { prefix.docs.emplace_back(_d, _f); };
+        get_doc_freqs_(prefix.node, limit, add_doc_freq);
+
+        prefix.exhausted = prefix.docs.size() < limit;
+        if (!prefix.exhausted) threshold += prefix.docs.back().second;
+      }
+
+      std::size_t read = 0;
+      for (const auto &prefix : prefixes) read += prefix.docs.size();
+      candidates.clear();
+      candidates.reserve(_border_freqs.size() + read);
+      for (const auto &item : _border_freqs) candidates[item.first].lower = item.second;
+      for (const auto &prefix : prefixes) {
+        uint32_t bound = prefix.exhausted ? 0 : prefix.docs.back().second;
+        for (const auto &doc_freq : prefix.docs) {
+          auto &bounds = candidates[doc_freq.first];
+          bounds.lower += doc_freq.second;
+          bounds.seen_bound += bound;
+        }
+      }
+
+      std::vector<DocFreq> lower_freqs;
+      lower_freqs.reserve(candidates.size());
+      for (const auto &item : candidates) lower_freqs.emplace_back(item.first, item.second.lower);
+      auto result = selectTopK(lower_freqs, _k);
+
+      if (threshold == 0) return result;  // All the sets are exhausted, so the frequencies are exact.
+      if (result.size() < _k) continue;   // Unseen documents can still enter the result.
+
+      const auto &kth = result.back();
+      if (threshold >= kth.second) continue;  // An unseen document could reach the k-th one.
+
+      auto upper = [threshold](const Bounds &_bounds) { return _bounds.lower + threshold - _bounds.seen_bound; };
+
+      bool done = true;
+      for (const auto &doc_freq : result) {
+        if (upper(candidates[doc_freq.first]) != doc_freq.second) {
+          done = false;  // Its frequency is not exact yet.
+          break;
+        }
+      }
+      for (auto it = candidates.begin(); done && it != candidates.end(); ++it) {
+        if (greater(DocFreq(it->first, upper(it->second)), kth) && !greater(DocFreq(it->first, it->second.lower), kth)) {
+          done = false;  // Outside the result, but it could still beat the k-th one.
+        }
+      }
+
+      if (done) return result;
+    }
+  }
+
+  /// The _k most frequent documents, sorted by DocFreqGreater, selected with a bounded heap
+  template<typename _Freqs>
+  static std::vector<DocFreq> selectTopK(const _Freqs &_freqs, std::size_t _k) {
+    // Min-heap (w.r.t. the result order) with the best k documents so far
+    DocFreqGreater greater;
+    std::vector<DocFreq> result;
+    result.reserve(std::min(_k, _freqs.size()));
+    for (const auto &item : _freqs) {
+      DocFreq doc_freq(item.first, item.second);
+      if (result.size() < _k) {
+        result.push_back(doc_freq);
+        std::push_heap(result.begin(), result.end(), greater);
+      } else if (greater(doc_freq, result.front())) {
+        std::pop_heap(result.begin(), result.end(), greater);
+        result.back() = doc_freq;
+        std::push_heap(result.begin(), result.end(), greater);
+      }
+    }
+
+    std::sort_heap(result.begin(), result.end(), greater);
+
+    return result;
+  }
+
+ protected:
+  const _ComputeCover &compute_cover_;
+  const _GetDocs &get_docs_;
+  const _GetDocFreqs &get_doc_freqs_;
+};
+
+
+template<typename _ComputeCover, typename _GetDocs, typename _GetDocFreqs>
+auto BuildDLTopK(const _ComputeCover &_compute_cover, const _GetDocs &_get_docs, const _GetDocFreqs &_get_doc_freqs) {
+  return DLTopK<_ComputeCover, _GetDocs, _GetDocFreqs>(_compute_cover, _get_docs, _get_doc_freqs);
+}
+
+}
+
+#endif //DRL_DL_TOPK_SCHEME_H
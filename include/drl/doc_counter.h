@@ -0,0 +1,140 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_DOC_COUNTER_H
+#define DRL_DOC_COUNTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/select_support.hpp>
+#include <sdsl/rmq_support.hpp>
+
+namespace drl {
+
+/**
+ * Sadakane's document counting structure using 2n + o(n) bits.
+ *
+ * For each pair of consecutive suffixes (in suffix array order) p < q of the same document, let t in (p, q] be the
+ * position of the minimum of LCP[p + 1..q], i.e., the LCA of both leaves. If h[t] is the number of pairs assigned to
+ * t, the number of repeated documents in a suffix tree node (pattern range) [sp, ep] is the sum of h[sp + 1..ep].
+ * The counts are stored in unary in the bitvector H = 1^h[0] 0 1^h[1] 0 ... 1^h[n - 1] 0, so each query takes two
+ * select_0 operations, independently of the number of documents.
+ *
+ * The ranges must be suffix tree nodes (e.g., the range of a pattern); the result for other ranges is undefined.
+ */
+class DocCounter {
+ public:
+  typedef std::size_t size_type;
+
+  DocCounter() = default;
+
+  /**
+   * Constructor.
+   *
+   * @param _c_array C array: C[q] = 1 + previous position of the document of q in the suffix array (0 if none)
+   * @param _lcp LCP array: LCP[i] = lcp(SA[i - 1], SA[i])
+   */
+  template<typename _CArray, typename _LCP>
+  DocCounter(const _CArray &_c_array, const _LCP &_lcp) {
+    auto n = _c_array.size();
+
+    sdsl::int_vector<> h(n, 0, 32);
+    {
+      sdsl::rmq_succinct_sct<true> rmq(&_lcp);
+
+      for (size_type q = 0; q < n; ++q) {
+        if (_c_array[q] == 0) continue;
+
+        auto p = _c_array[q] - 1;
+        ++h[rmq(p + 1, q)];
+      }
+    }
+
+    size_type ones = 0;
+    for (size_type i = 0; i < n; ++i) ones += h[i];
+
+    bits_ = sdsl::bit_vector(ones + n, 1);
+    for (size_type i = 0, pos = 0; i < n; ++i) {
+      pos += h[i];
+      bits_[pos++] = 0;
+    }
+
+    select0_ = sdsl::select_support_mcl<0, 1>(&bits_);
+  }
+
+  DocCounter(const DocCounter &_other) : bits_(_other.bits_), select0_(_other.select0_) {
+    select0_.set_vector(&bits_);
+  }
+
+  DocCounter(DocCounter &&_other) noexcept {
+    *this = std::move(_other);
+  }
+
+  DocCounter &operator=(const DocCounter &_other) {
+    if (this != &_other) {
+      bits_ = _other.bits_;
+      select0_ = _other.select0_;
+      select0_.set_vector(&bits_);
+    }
+    return *this;
+  }
+
+  DocCounter &operator=(DocCounter &&_other) noexcept {
+    if (this != &_other) {
+      bits_ = std::move(_other.bits_);
+      select0_ = std::move(_other.select0_);
+      select0_.set_vector(&bits_);
+    }
+    return *this;
+  }
+
+  /**
+   * Number of distinct documents in the suffix tree node [_bp, _ep).
+   */
+  size_type count(size_type _bp, size_type _ep) const {
+    if (_ep <= _bp) return 0;
+
+    auto last = _ep - 1;
+    auto repeated = (zero(last) - last) - (zero(_bp) - _bp);
+
+    return (_ep - _bp) - repeated;
+  }
+
+  size_type size() const {
+    return bits_.size();
+  }
+
+  size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, const std::string &name = "") const {
+    auto child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+
+    size_type written_bytes = 0;
+    written_bytes += sdsl::serialize(bits_, out, child, "bits");
+    written_bytes += sdsl::serialize(select0_, out, child, "select0");
+
+    sdsl::structure_tree::add_size(child, written_bytes);
+
+    return written_bytes;
+  }
+
+  void load(std::istream &in) {
+    sdsl::load(bits_, in);
+    select0_.load(in, &bits_);
+  }
+
+ private:
+  /// Position in H of the (i + 1)-th 0, i.e., sum of h[0..i] + i
+  size_type zero(size_type _i) const {
+    return select0_(_i + 1);
+  }
+
+  sdsl::bit_vector bits_;
+  sdsl::select_support_mcl<0, 1> select0_;
+};
+
+}
+
+#endif //DRL_DOC_COUNTER_H
@@ -4,6 +4,7 @@
 #include <sdsl/rmq_support.hpp>
 
 #include "utils.h"
+#include "doc_counter.h"
 
 //--------------------------------------------------------------------------
 
@@ -15,12 +16,14 @@ class Doclist
     typedef enum { st_unfinished, st_error, st_ok } status_type;
 
     const static std::string DOCARRAY_EXTENSION;
+    const static std::string COUNTER_EXTENSION;
 
     explicit Doclist(const RLCSA& _rlcsa);
     virtual ~Doclist();
 
     inline bool isOk() const { return (this->status == st_ok); }
     inline bool hasDocArray() const { return (this->docarray != 0); }
+    inline bool hasCounter() const { return (this->counter != 0); }
 
     virtual void writeTo(const std::string& base_name) const = 0;
     virtual void writeTo(std::ofstream& output) const = 0;
@@ -33,10 +36,22 @@ class Doclist
     result_type* listDocuments(const std::string& pattern, found_type* found = 0) const;
     result_type* listDocuments(pair_type range, found_type* found = 0) const;
 
+    // These variants write the documents into the given vector, which is cleared first
+    // and can be reused between queries. Without a found buffer, the queries use a
+    // thread-local buffer, so they do not allocate memory once the buffers have grown.
+    // Returns false if the query could not be answered.
+    bool listDocuments(const std::string& pattern, result_type& results, found_type* found = 0) const;
+    bool listDocuments(pair_type range, result_type& results, found_type* found = 0) const;
+
     // This variant uses brute force.
     result_type* listDocumentsBrute(const std::string& pattern) const;
     result_type* listDocumentsBrute(pair_type range) const;
 
+    // Number of distinct documents without listing them. With the document counter,
+    // this takes O(1) time, but the range must be the range of a pattern.
+    usint countDocuments(const std::string& pattern) const;
+    usint countDocuments(pair_type range) const;
+
   protected:
     typedef sdsl::rmq_succinct_sct<true,
             sdsl::bp_support_sada<256,32,sdsl::rank_support_v5<> > > RMQType;
@@ -44,6 +59,7 @@ class Doclist
     const RLCSA&     rlcsa;
     CSA::ReadBuffer* docarray;
     RMQType*         rmq;
+    drl::DocCounter* counter;
     status_type      status;
 
     usint commonStructureSize() const;
@@ -57,12 +73,16 @@ class Doclist
     void writeDocs(const std::string& base_name) const;
     void writeDocs(std::ofstream& output) const;
 
+    void readCounter(const std::string& base_name);
+    void writeCounter(const std::string& base_name) const;
+
     virtual pair_type getRMQRange(pair_type sa_range) const = 0;
     virtual usint docAt(usint rmq_index, pair_type sa_range) const = 0;
     virtual void addDocs(usint first_doc, usint rmq_index, result_type* results, found_type* found, pair_type sa_range) const = 0;
 
   private:
     result_type* listUnsafe(pair_type range, found_type* found) const;
+    void listUnsafe(pair_type range, found_type* found, result_type& results) const;
     result_type* listUnsafeBrute(pair_type range) const;
 
     // These are not allowed.
@@ -78,9 +98,9 @@ class DoclistSada : public Doclist
   public:
     const static std::string EXTENSION;
 
-    explicit DoclistSada(const RLCSA& _rlcsa, bool store_docarray = false);
+    explicit DoclistSada(const RLCSA& _rlcsa, bool store_docarray = false, bool build_counter = false);
     DoclistSada(const RLCSA& _rlcsa, std::ifstream& input, bool load_docarray = false);
-    DoclistSada(const RLCSA& _rlcsa, const std::string& base_name, bool load_docarray = false);
+    DoclistSada(const RLCSA& _rlcsa, const std::string& base_name, bool load_docarray = false, bool load_counter = false);
     virtual ~DoclistSada();
 
     virtual void writeTo(const std::string& base_name) const;
@@ -121,6 +141,12 @@ class DoclistILCP : public Doclist
     virtual usint reportSize() const;
     virtual usint reportSizeBrute() const;
 
+    // Builds the ILCP array and returns the values of its run heads, i.e., the array indexed by the RMQ.
+    // If run_heads is not null, it receives the starting positions of the runs.
+    // The ILCP array is streamed, so the construction uses about 2n bits plus the run heads,
+    // but it locates every suffix array position.
+    static sdsl::int_vector<32> buildRunHeads(const RLCSA& rlcsa, CSA::DeltaVector** run_heads = 0);
+
   protected:
     virtual pair_type getRMQRange(pair_type sa_range) const;
     virtual usint docAt(usint rmq_index, pair_type sa_range) const;
@@ -128,6 +154,7 @@ class DoclistILCP : public Doclist
 
   private:
     const static usint DV_BLOCK_SIZE = 32;
+    const static usint BLOCK_SIZE = CSA::MEGABYTE;
 
     CSA::DeltaVector* run_heads;
 
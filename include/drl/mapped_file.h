@@ -0,0 +1,103 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_MAPPED_FILE_H
+#define DRL_MAPPED_FILE_H
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <rlcsa/rlcsa.h>
+
+namespace drl {
+
+/**
+ * Read-only memory mapping of an index file.
+ *
+ * The pages are shared through the page cache, so processes loading the same file share the memory and a restarted
+ * process finds the pages already resident. Structures loaded with views into the mapping (see LoadReadBuffer) must not
+ * outlive it, so the loaders keep a shared pointer to the mapping.
+ */
+class MappedFile {
+ public:
+  /**
+   * @param _file_name File to map
+   * @param _populate If true, read the whole file into the page cache at once (MAP_POPULATE)
+   */
+  explicit MappedFile(const std::string &_file_name, bool _populate = false) {
+    int fd = open(_file_name.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+      if (_populate) flags |= MAP_POPULATE;
+#endif
+      void *addr = mmap(nullptr, st.st_size, PROT_READ, flags, fd, 0);
+      if (addr != MAP_FAILED) {
+        data_ = static_cast<const char *>(addr);
+        size_ = st.st_size;
+      }
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (data_ != nullptr) munmap(const_cast<char *>(data_), size_);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isOk() const { return data_ != nullptr; }
+
+  const char *data() const { return data_; }
+
+  std::size_t size() const { return size_; }
+
+  /// The queries access the file at random, so disable read-ahead
+  void adviseRandom() const {
+    if (isOk()) madvise(const_cast<char *>(data_), size_, MADV_RANDOM);
+  }
+
+ private:
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+
+/**
+ * Load a CSA::ReadBuffer of _items items of _item_bits bits stored at the current position of _in.
+ *
+ * If _file maps the file read by _in and the data is aligned to words, the buffer is a view into the mapped pages and
+ * _in skips the data. Otherwise, the buffer is read from the stream.
+ */
+inline CSA::ReadBuffer *LoadReadBuffer(std::ifstream &_in,
+                                       const std::shared_ptr<MappedFile> &_file,
+                                       CSA::usint _items,
+                                       CSA::usint _item_bits) {
+  if (_file != nullptr && _file->isOk()) {
+    auto offset = static_cast<std::size_t>(_in.tellg());
+    auto words = (_items * _item_bits + CSA::WORD_BITS - 1) / CSA::WORD_BITS;
+    if (offset % sizeof(CSA::usint) == 0 && offset + words * sizeof(CSA::usint) <= _file->size()) {
+      _in.seekg(words * sizeof(CSA::usint), std::ios_base::cur);
+      auto data = reinterpret_cast<const CSA::usint *>(_file->data() + offset);
+      return new CSA::ReadBuffer(data, _items, _item_bits);
+    }
+  }
+
+  return new CSA::ReadBuffer(_in, _items, _item_bits);
+}
+
+}
+
+#endif //DRL_MAPPED_FILE_H
@@ -5,7 +5,12 @@
 #ifndef DRL_PDL_SUFFIX_TREE_H
 #define DRL_PDL_SUFFIX_TREE_H
 
+#include <memory>
+#include <vector>
+
 #include "pdltree.h"
+#include "rule_cache.h"
+#include "sink.h"
 
 
 namespace drl {
@@ -102,6 +107,47 @@ class ComputeCoverSuffixTreeFunctor {
     return Compute(_sp, _ep);
   }
 
+  /**
+   * Compute the covers of a batch of ranges [bp, ep). The first and last blocks of all ranges are found with one sweep
+   * over the leaves (PDLTree::getFirstAndLastBlocks). The output vectors are cleared first and can be reused.
+   *
+   * @param _ranges Ranges [bp, ep)
+   * @param _covered For each range, the part covered by the nodes, as returned by Compute
+   * @param _nodes Nodes of all covers; the nodes of range i are [_offsets[i], _offsets[i + 1])
+   * @param _offsets Offsets of the covers in _nodes, plus the total number of nodes
+   */
+  void ComputeBatch(const std::vector<std::pair<std::size_t, std::size_t>> &_ranges,
+                    std::vector<std::pair<std::size_t, std::size_t>> &_covered,
+                    std::vector<std::size_t> &_nodes,
+                    std::vector<std::size_t> &_offsets) const {
+    // Per-thread buffers, so the functor can be shared by concurrent queries
+    static thread_local std::vector<pair_type> sa_ranges, first_blocks, last_blocks;
+    sa_ranges.clear();
+    for (const auto &range : _ranges) {
+      sa_ranges.emplace_back(range.first, range.second - 1);
+    }
+    tree_.getFirstAndLastBlocks(sa_ranges, first_blocks, last_blocks);
+
+    _covered.clear();
+    _nodes.clear();
+    _offsets.clear();
+    auto report = [&_nodes](const auto &_value) { _nodes.emplace_back(_value); };
+    for (std::size_t i = 0; i < _ranges.size(); ++i) {
+      _offsets.emplace_back(_nodes.size());
+
+      usint current = first_blocks[i].second;
+      usint limit = last_blocks[i].second + 1;  // First block not in the range.
+      while (current < limit) {
+        pair_type ancestor = tree_.getAncestor(current, limit);
+        report(ancestor.first);
+        current = (ancestor.first == current) ? current + 1 : ancestor.second;
+      }
+
+      _covered.emplace_back(first_blocks[i].first, last_blocks[i].first + 1);
+    }
+    _offsets.emplace_back(_nodes.size());
+  }
+
  protected:
   const _Tree &tree_;
 };
@@ -116,9 +162,13 @@ auto BuildComputeCoverSuffixTreeFunctor(const _Tree &_tree) {
 template<typename _Tree, typename _Blocks, typename _Grammar>
 class GetDocsSuffixTreeRP {
  public:
-  GetDocsSuffixTreeRP(const _Tree &_tree, const _Blocks &_blocks, const _Grammar &_grammar) : tree_{_tree},
-                                                                                              blocks_{_blocks},
-                                                                                              grammar_{_grammar} {}
+  /**
+   * @param _cache If given, the expansions of the rules stored in the blocks are looked up and cached in it
+   */
+  GetDocsSuffixTreeRP(const _Tree &_tree,
+                      const _Blocks &_blocks,
+                      const _Grammar &_grammar,
+                      RuleCache *_cache = nullptr) : tree_{_tree}, blocks_{_blocks}, grammar_{_grammar}, cache_{_cache} {}
 
   auto operator[](std::size_t _i) const {
     std::vector<uint32_t> set;
@@ -129,38 +179,75 @@ class GetDocsSuffixTreeRP {
     return set;
   }
 
+  /**
+   * Report the documents of the given blocks in their stored order, stopping after _limit documents.
+   */
   template<typename _Report>
-  void addBlocks(usint first_block, usint number_of_blocks, _Report &_report) const {
+  void addBlocks(usint first_block, usint number_of_blocks, _Report &_report, std::size_t _limit = kNoLimit) const {
+    std::size_t reported = 0;
+    auto report = [&_report, &reported, _limit](const auto &_d) {
+      if (reported < _limit) {
+        _report(_d);
+        ++reported;
+      }
+    };
+    auto stop = [&reported, _limit]() { return _limit <= reported; };
+
+    addBlocksUntil(first_block, number_of_blocks, report, stop);
+  }
+
+  /**
+   * Report the documents of the given blocks in their stored order, stopping as soon as _stop() returns true.
+   */
+  template<typename _Report, typename _Stop>
+  void addBlocksUntil(usint first_block, usint number_of_blocks, _Report &_report, const _Stop &_stop) const {
+    if (_stop()) return;
+
     CSA::MultiArray::Iterator *iter = blocks_.getIterator();
     iter->goToItem(first_block, 0);
     iter->setEnd(first_block + number_of_blocks, 0);
 
-    std::stack<usint> buffer;
-    while (!(iter->atEnd())) {
-      buffer.push(iter->nextItem());
-      while (!(buffer.empty())) {
-        usint value = buffer.top();
-        buffer.pop();
+    thread_local std::vector<usint> buffer;
+    thread_local std::vector<uint32_t> expansion;
+    buffer.clear();
+    while (!(iter->atEnd()) && !_stop()) {
+      usint value = iter->nextItem();
+
+      // Look up the rules stored in the block in the cache, and cache their (complete) expansions on a miss.
+      usint rule = 0;
+      bool cached = (cache_ != nullptr && !tree_.isTerminal(value));
+      if (cached) {
+        rule = tree_.toRule(value);
+        if (cache_->report(rule, _report)) continue;
+        expansion.clear();
+      }
+
+      buffer.push_back(value);
+      while (!(buffer.empty()) && !_stop()) {
+        value = buffer.back();
+        buffer.pop_back();
         if (tree_.isTerminal(value)) {
           if (value == tree_.getNumberOfDocuments()) {
             delete iter;
 //            iter = 0;
 //            allDocuments(this->tree->getNumberOfDocuments(), _report);
-            for (std::size_t i = 0; i < tree_.getNumberOfDocuments(); ++i) {
+            for (std::size_t i = 0; i < tree_.getNumberOfDocuments() && !_stop(); ++i) {
               _report(i);
 //              _report.emplace_back(i);
             }
             return;
           } else {
             _report(value);
-//            _report.emplace_back(value);
+            if (cached) expansion.emplace_back(value);
           }
         } else {
           value = tree_.toRule(value);
-          buffer.push(grammar_.readItemConst(2 * value + 1));
-          buffer.push(grammar_.readItemConst(2 * value));
+          buffer.push_back(grammar_.readItemConst(2 * value + 1));
+          buffer.push_back(grammar_.readItemConst(2 * value));
         }
       }
+
+      if (cached && buffer.empty()) cache_->insert(rule, expansion.begin(), expansion.end());
     }
 
     delete iter;
@@ -211,27 +298,87 @@ class GetDocsSuffixTreeRP {
   const _Tree &tree_;
   const _Blocks &blocks_;
   const _Grammar &grammar_;
+  RuleCache *cache_;
 };
 
 
 template<typename _Tree, typename _Blocks, typename _Grammar>
-auto BuildGetDocsSuffixTreeRP(const _Tree &_tree, const _Blocks &_blocks, const _Grammar &_grammar) {
-  return GetDocsSuffixTreeRP<_Tree, _Blocks, _Grammar>(_tree, _blocks, _grammar);
+auto BuildGetDocsSuffixTreeRP(const _Tree &_tree,
+                              const _Blocks &_blocks,
+                              const _Grammar &_grammar,
+                              RuleCache *_cache = nullptr) {
+  return GetDocsSuffixTreeRP<_Tree, _Blocks, _Grammar>(_tree, _blocks, _grammar, _cache);
+}
+
+
+/**
+ * Documents of the sets of the suffix tree nodes with their frequencies, in decreasing order of frequency.
+ *
+ * The sets must be stored sorted by frequency (PDLTree::mode_topk), and the frequencies are the runs (value, length)
+ * given by PDLTree::getFrequencies(), where the values are differences with the previous run if differential.
+ */
+template<typename _GetDocSet, typename _Freqs>
+class GetDocFreqsSuffixTree {
+ public:
+  GetDocFreqsSuffixTree(const _GetDocSet &_get_doc_set, const _Freqs &_freqs, bool _differential_encoding)
+      : get_doc_set_{_get_doc_set}, freqs_{_freqs}, differential_encoding_{_differential_encoding} {}
+
+  /**
+   * Report at most _limit pairs (doc, freq) of the set of _node.
+   */
+  template<typename _Report>
+  void operator()(std::size_t _node, std::size_t _limit, _Report &_report) const {
+    CSA::MultiArray::Iterator *iter = freqs_.getIterator();
+    iter->goToItem(_node, 0);
+    iter->setEnd(_node + 1, 0);
+
+    usint freq = 0, run = 0;
+    bool first = true;
+    auto report = [&](const auto &_d) {
+      if (run == 0 && !(iter->atEnd())) {
+        usint value = iter->nextItem();
+        run = iter->nextItem();
+        freq = (first || !differential_encoding_) ? value : freq - value;
+        first = false;
+      }
+      --run;
+      _report(_d, freq);
+    };
+
+    get_doc_set_.addBlocks(_node, 1, report, _limit);
+
+    delete iter;
+  }
+
+ private:
+  const _GetDocSet &get_doc_set_;
+  const _Freqs &freqs_;
+  bool differential_encoding_;
+};
+
+
+template<typename _GetDocSet, typename _Freqs>
+auto BuildGetDocFreqsSuffixTree(const _GetDocSet &_get_doc_set, const _Freqs &_freqs, bool _differential_encoding) {
+  return GetDocFreqsSuffixTree<_GetDocSet, _Freqs>(_get_doc_set, _freqs, _differential_encoding);
 }
 
 
 template<typename _Tree>
 class PDLBC {
  public:
-  PDLBC(const _Tree &_tree, std::ifstream &_in, usint _flags) : tree_{_tree}, uses_rle{false} {
+  /**
+   * @param _file If it maps the file read by _in, the rules and the blocks are views into it (see LoadReadBuffer)
+   */
+  PDLBC(const _Tree &_tree, std::ifstream &_in, usint _flags, std::shared_ptr<MappedFile> _file = nullptr)
+      : tree_{_tree}, mapped_file_{std::move(_file)}, uses_rle{false} {
     if (_flags & RLE_FLAG) {
       uses_rle = true;
     }
 
     rule_borders = std::make_shared<CSA::SuccinctVector>(_in);
-    rules = std::make_shared<CSA::ReadBuffer>(_in, rule_borders->getSize(), CSA::length(getNumberOfDocuments()));
+    rules.reset(LoadReadBuffer(_in, mapped_file_, rule_borders->getSize(), CSA::length(getNumberOfDocuments())));
     block_borders = std::make_shared<CSA::SuccinctVector>(_in);
-    blocks = std::make_shared<CSA::ReadBuffer>(_in, block_borders->getSize(), CSA::length(maxInteger()));
+    blocks.reset(LoadReadBuffer(_in, mapped_file_, block_borders->getSize(), CSA::length(maxInteger())));
     has_grammar = true;
   }
 
@@ -306,6 +453,7 @@ class PDLBC {
 
  private:
   const _Tree &tree_;
+  std::shared_ptr<MappedFile> mapped_file_;
 
   std::shared_ptr<CSA::SuccinctVector> rule_borders;
   std::shared_ptr<CSA::ReadBuffer> rules;        // this->getNumberOfDocs() means all documents.
@@ -0,0 +1,46 @@
+#ifndef _DOCLIST_PDLCOUNT_H
+#define _DOCLIST_PDLCOUNT_H
+
+#include "pdltree.h"
+
+
+// Document counting with a PDLTree built in mode_count (PDL-count) or mode_fc (PDL-fast).
+// The tree stores the number of distinct documents for each node. Ranges that do not
+// correspond to a node are counted by brute force, except for pattern ranges inside a
+// leaf of PDL-fast, where each document occurs at most once.
+class PDLCount
+{
+  public:
+    // If fast_count is true, uses mode_fc and PDLTree::FAST_COUNT_EXTENSION.
+    // Otherwise uses mode_count and PDLTree::COUNT_EXTENSION.
+    PDLCount(const RLCSA& _rlcsa, usint block_size, bool fast_count, bool print = false);
+    PDLCount(const RLCSA& _rlcsa, const std::string& base_name, bool fast_count);
+    ~PDLCount();
+
+    inline bool isOk() const { return this->ok; }
+
+    void writeTo(const std::string& base_name) const;
+    usint reportSize() const;
+
+    usint count(const std::string& pattern) const;
+
+    // In PDL-fast, sa_range must be the range of a pattern.
+    usint count(pair_type sa_range) const;
+
+  private:
+    const RLCSA& rlcsa;
+    bool         fast_count, ok;
+
+    PDLTree*     tree;
+    CSA::Array*  counts;
+
+    std::string getFileName(const std::string& base_name) const;
+
+    // These are not allowed.
+    PDLCount();
+    PDLCount(const PDLCount&);
+    PDLCount& operator = (const PDLCount&);
+};
+
+
+#endif  // _DOCLIST_PDLCOUNT_H
@@ -17,6 +17,10 @@
 #include <grammar/algorithm.h>
 
 #include "construct_da.h"
+#include "dedup.h"
+#include "dl_sampled_tree_scheme.h"
+#include "reported_set.h"
+#include "sink.h"
 
 
 namespace drl {
@@ -252,8 +256,7 @@ class PDLODA {
 //      sa_.GetDocs(range.second, end, docs);
       get_terms_(range.second, end, docs, sa_, slp_, pts_);
     }
-    sort(docs.begin(), docs.end());
-    docs.erase(unique(docs.begin(), docs.end()), docs.end());
+    Dedup(docs);
 
     if (span_cover.empty()) {
       return docs;
@@ -354,8 +357,7 @@ class PDLGT {
       get_terms_(_first, range.first, docs, sa_, slp_, pts_);
       get_terms_(range.second, _last, docs, sa_, slp_, pts_);
     }
-    sort(docs.begin(), docs.end());
-    docs.erase(unique(docs.begin(), docs.end()), docs.end());
+    Dedup(docs);
 
     if (span_cover.empty()) {
       return docs;
@@ -444,12 +446,58 @@ class PDLGT {
       _result.swap(part_results.front().second);
     }
 
-    sort(docs.begin(), docs.end());
-    docs.erase(unique(docs.begin(), docs.end()), docs.end());
+    Dedup(docs);
 
     return docs;
   }
 
+  /**
+   * Search the documents in [_first, _last) into a sink (callable or output iterator), stopping after _limit
+   * documents.
+   *
+   * Documents are emitted (without repetitions) as they are found: first the terms of the uncovered borders of the
+   * range, and then the sets of the span cover. The borders are resolved in chunks and the sets are expanded with
+   * ReportDocSetUntil, so the work stops soon after the limit is reached.
+   *
+   * @return Number of documents emitted
+   */
+  template<typename _Sink>
+  std::size_t SearchInRange(std::size_t _first, std::size_t _last, _Sink &&_sink, std::size_t _limit = kNoLimit) {
+    if (_first >= _last || _limit == 0) return 0;
+
+    auto sink = BuildLimitedSink(_sink, _limit);
+
+    ReportedHashSet seen;
+    seen.Prepare(std::min(std::min(_limit, _last - _first), kSeenDocsInitialSize));
+
+    auto add_doc = [&sink, &seen](const auto &_d) {
+      if (sink.full() || seen.Test(_d)) return;
+
+      seen.Set(_d);
+      sink(_d);
+    };
+
+    std::vector<std::size_t> span_cover;
+    auto range = cover_(slp_, _first, _last, back_inserter(span_cover));
+
+    // Terms of the uncovered borders of the range
+    std::vector<uint32_t> terms;
+    if (span_cover.empty()) {
+      getTermsUntilFull(_first, _last, terms, add_doc, sink, _limit);
+      return sink.count();
+    }
+
+    getTermsUntilFull(_first, range.first, terms, add_doc, sink, _limit);
+    getTermsUntilFull(range.second, _last, terms, add_doc, sink, _limit);
+
+    auto full = [&sink]() { return sink.full(); };
+    for (auto it = span_cover.begin(); it != span_cover.end() && !sink.full(); ++it) {
+      ReportDocSetUntil(pts_, *it, add_doc, full);
+    }
+
+    return sink.count();
+  }
+
   std::size_t serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, const std::string &name = "") const {
     std::size_t written_bytes = 0;
     written_bytes += sdsl::serialize(slp_, out);
@@ -472,6 +520,31 @@ class PDLGT {
   _ComputeSpanCover cover_;
 
   _ComputeRangeTerms get_terms_;
+
+ private:
+  /**
+   * Report the terms in [_b, _e) in chunks of at least the number of documents still missing, until the sink is full.
+   */
+  template<typename _Report, typename _LimitedSink>
+  void getTermsUntilFull(std::size_t _b,
+                         std::size_t _e,
+                         std::vector<uint32_t> &_terms,
+                         _Report &_report,
+                         const _LimitedSink &_sink,
+                         std::size_t _limit) {
+    while (_b < _e && !_sink.full()) {
+      auto chunk = std::max(_limit - _sink.count(), kMinBorderChunkSize);
+      auto e = (_e - _b <= chunk) ? _e : _b + chunk;
+
+      _terms.clear();
+      get_terms_(_b, e, _terms, sa_, slp_, pts_);
+      for (auto it = _terms.begin(); it != _terms.end() && !_sink.full(); ++it) {
+        _report(*it);
+      }
+
+      _b = e;
+    }
+  }
 };
 
 
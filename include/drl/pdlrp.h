@@ -2,6 +2,7 @@
 #define _DOCLIST_PDLRP_H
 
 #include "pdltree.h"
+#include "rule_cache.h"
 
 
 class PDLRP
@@ -14,7 +15,13 @@ class PDLRP
     const static std::string SET_EXTENSION; // .pdlset
 
     // If compress_sets is true, sets and grammar will be read from the files compressed by irepair.
-    PDLRP(const RLCSA& _rlcsa, const std::string& base_name, bool compress_sets, bool use_rpset = false);
+    // If fast_tree is true, the tree is converted to the fast layout (see PDLTree::buildFastLayout()).
+    // If mapped is true, the input file is memory-mapped and the tree and the grammar view its pages
+    // (see drl::MappedFile). If populate is also true, the file is read into memory at once.
+    // If rule_cache > 0, the expansions of the rules stored in the blocks are cached in up to
+    // rule_cache bytes shared by all queries (see drl::RuleCache). The cache is not included in reportSize().
+    PDLRP(const RLCSA& _rlcsa, const std::string& base_name, bool compress_sets, bool use_rpset = false,
+          bool fast_tree = false, bool mapped = false, bool populate = false, usint rule_cache = 0);
     ~PDLRP();
 
     inline bool isOk() const { return (this->status == st_ok); }
@@ -26,9 +33,17 @@ class PDLRP
     result_type* query(const std::string& pattern) const;
     result_type* query(pair_type sa_range) const;
 
+    // These variants write the documents into the given vector, which is cleared first
+    // and can be reused between queries. Returns false if the query could not be answered.
+    bool query(const std::string& pattern, result_type& result) const;
+    bool query(pair_type sa_range, result_type& result) const;
+
     usint count(const std::string& pattern) const;
     usint count(pair_type sa_range) const;
 
+    // Returns 0 if the rule cache is not used.
+    inline const drl::RuleCache* getRuleCache() const { return this->cache; }
+
   private:
     const RLCSA&     rlcsa;
     status_type      status;
@@ -36,8 +51,11 @@ class PDLRP
     PDLTree*         tree;
     CSA::ReadBuffer* grammar;
     CSA::MultiArray* blocks;
+    std::shared_ptr<drl::MappedFile> mapped_file;
+    drl::RuleCache*  cache;
 
     result_type* queryUnsafe(pair_type sa_range) const;
+    void queryUnsafe(pair_type sa_range, result_type& result) const;
 
     // Returns true if CONTAINS_ALL is encountered.
     bool addBlocks(usint first_block, usint number_of_blocks, result_type* result) const;
@@ -2,12 +2,15 @@
 #define _DOCLIST_PDLTREE_H
 
 #include <cstdio>
+#include <memory>
 
 #include <rlcsa/bits/multiarray.h>
 
 #include "utils.h"
+#include "mapped_file.h"
 
 struct PDLTreeNode;
+class PDLTreeNodeArena;
 
 //--------------------------------------------------------------------------
 
@@ -22,9 +25,15 @@ class PDLTree
     typedef enum { mode_rp, mode_set, mode_topk, mode_merge, mode_count, mode_fc } mode_type;
     typedef enum { sort_none, sort_topk, sort_id } sort_type;
 
-    PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_parameter, mode_type _mode, bool print = false);
-    PDLTree(const RLCSA& _rlcsa, std::ifstream& input);
-    PDLTree(const RLCSA& _rlcsa, FILE* input);
+    // If memory_budget > 0 (in bytes) and the SA/DA and LCP arrays used during construction
+    // do not fit in it, they are stored in memory-mapped scratch files in temp_dir.
+    PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_parameter, mode_type _mode, bool print = false,
+            usint memory_budget = 0, const std::string& temp_dir = "/tmp");
+    // If fast_layout is true, builds the fast layout after loading the tree.
+    // If mapped_file maps the file read by input, the parents and next leaves are views into it.
+    PDLTree(const RLCSA& _rlcsa, std::ifstream& input, bool fast_layout = false,
+            const std::shared_ptr<drl::MappedFile>& mapped_file = std::shared_ptr<drl::MappedFile>());
+    PDLTree(const RLCSA& _rlcsa, FILE* input, bool fast_layout = false);
     ~PDLTree();
 
     void writeTo(std::ofstream& output) const;
@@ -44,6 +53,12 @@ class PDLTree
     // Removes the explicit tree structure used during construction.
     void deleteNodes();
 
+    // Converts the tree into a layout for faster queries: the leaf boundaries in Eytzinger
+    // order, and plain arrays of parents and next leaves. The compressed structures are kept
+    // for writeTo(). The extra space is included in reportSize().
+    void buildFastLayout();
+    inline bool hasFastLayout() const { return this->fast; }
+
 //--------------------------------------------------------------------------
 
     // Returns this->getNumberOfNodes(), if the range does not correspond to any block.
@@ -61,6 +76,11 @@ class PDLTree
     // If no such block exists, the block_id is this->getNumberOfNodes().
     pair_type getLastBlock(pair_type sa_range) const;
 
+    // Batch variant of getFirstBlock() and getLastBlock() for many ranges. The range boundaries
+    // are processed in sorted order with one sweep over the leaf boundaries.
+    void getFirstAndLastBlocks(const std::vector<pair_type>& sa_ranges,
+      std::vector<pair_type>& first_blocks, std::vector<pair_type>& last_blocks) const;
+
     // Finds the first block starting strictly after the end of sa_range.
     // Returns (starting_position, block_id).
     pair_type getNextBlock(pair_type sa_range) const;
@@ -155,6 +175,11 @@ class PDLTree
     const static usint FREQ_BLOCK_SIZE = 32;
     const static usint COUNT_BLOCK_SIZE = 32;
 
+    const static uint NO_PARENT = ~(uint)0;
+
+    // Boundaries at most this many leaves apart are reached by stepping the iterator in batches.
+    const static usint SWEEP_STEPS = 8;
+
     const RLCSA& rlcsa;
     usint block_size, storing_parameter;
 
@@ -167,12 +192,32 @@ class PDLTree
     CSA::SuccinctVector* first_children;
     CSA::ReadBuffer*     parents;
     CSA::ReadBuffer*     next_leaves;
+    std::shared_ptr<drl::MappedFile> mapped_file;  // Keeps the views valid.
+
+    // The fast layout. The leaf starts include getSize() as a sentinel, and the Eytzinger
+    // arrays are 1-based. node_parents[i] is the parent of node i as an internal node,
+    // or NO_PARENT if the node is not a first child.
+    bool               fast;
+    std::vector<usint> leaf_starts;
+    std::vector<usint> leaf_tree;
+    std::vector<uint>  leaf_tree_ranks;
+    std::vector<uint>  node_parents;
+    std::vector<uint>  internal_next_leaves;
+
+    // Returns the number of leaves starting before pos.
+    usint leavesBefore(usint pos) const;
+
+    // Returns false if sa_range does not start and end at block boundaries.
+    bool getBlockBoundaries(pair_type sa_range, pair_type& first_block, pair_type& next_block) const;
 
     // These are used during construction.
+    PDLTreeNodeArena* nodes;
     PDLTreeNode* root;
     PDLTreeNode** getNodesInOrder(sort_type _sort_order);
+    void buildSet(PDLTreeNode* curr, usint* documents, uint docs, uint& leaves, uint& nodes);
 
     // These are used during queries.
+    pair_type lastBlock(pair_type sa_range, pair_type last_block, pair_type next_block) const;
     pair_type getFirstBlock(pair_type sa_range, CSA::DeltaVector::Iterator& iter) const;
     pair_type getNextBlock(pair_type sa_range, CSA::DeltaVector::Iterator& iter) const;
     pair_type parentOf(usint tree_node, CSA::SuccinctVector::Iterator& iter) const;
@@ -195,25 +240,28 @@ struct PDLTreeNode
   pair_type    range;
   PDLTreeNode* parent;
   PDLTreeNode* child;
+  PDLTreeNode* last_child;  // For appending children in constant time.
   PDLTreeNode* sibling;
   PDLTreeNode* next;
 
   usint        stored_documents;
   uint         id;
   bool         contains_all;
+  bool         remove_this;   // Not stored; removed when processing the parent.
 
   std::vector<Document>* docs;
 
+  // The nodes are owned by a PDLTreeNodeArena. Deleting a node only deletes its document set.
   PDLTreeNode(uint lcp, pair_type sa_range);
   ~PDLTreeNode();
 
   void addChild(PDLTreeNode* node);
-  void addSibling(PDLTreeNode* node);
 
-  void deleteChildren();
+  // Detaches the children and returns the nodes in their subtrees to the arena.
+  void deleteChildren(PDLTreeNodeArena& arena);
 
-  void addLeaves();   // Adds leaves to the sparse suffix tree when required.
-  PDLTreeNode* addLeaf(PDLTreeNode* left, PDLTreeNode* right, usint pos);
+  void addLeaves(PDLTreeNodeArena& arena);   // Adds leaves to the sparse suffix tree when required.
+  PDLTreeNode* addLeaf(PDLTreeNode* left, PDLTreeNode* right, usint pos, PDLTreeNodeArena& arena);
 
   bool verifyTree();  // Call this to ensure that the tree is correct.
 
@@ -237,6 +285,37 @@ struct PDLTreeNode
   const static usint PARALLEL_SORT_THRESHOLD = 32768;
 };
 
+// Allocates the nodes in blocks and deletes them all at once. Released nodes are kept in a
+// free list and reused by create() before new slots are used.
+class PDLTreeNodeArena
+{
+  public:
+    PDLTreeNodeArena();
+    ~PDLTreeNodeArena();
+
+    PDLTreeNode* create(uint lcp, pair_type sa_range);
+
+    // Deletes the document set of a node that is no longer in the tree and makes the node
+    // available to create(). This is not thread-safe.
+    void release(PDLTreeNode* node);
+
+    void clear();
+
+    inline usint size() const { return this->nodes - this->released; }
+
+    const static usint BLOCK_SIZE = 4096;  // Nodes.
+
+  private:
+    std::vector<PDLTreeNode*> blocks;
+    usint                     nodes;     // Slots used in the blocks.
+    PDLTreeNode*              free_list; // Linked through the next field.
+    usint                     released;
+
+    // These are not allowed.
+    PDLTreeNodeArena(const PDLTreeNodeArena&);
+    PDLTreeNodeArena& operator = (const PDLTreeNodeArena&);
+};
+
 //--------------------------------------------------------------------------
 
 inline void
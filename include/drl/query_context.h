@@ -0,0 +1,137 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_QUERY_CONTEXT_H
+#define DRL_QUERY_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+#include "reported_set.h"
+
+namespace drl {
+
+/**
+ * Scratch space of the iterative RMQ-based listing engine (see ListDocsRMQSchemeBatched).
+ */
+struct RMQFrontier {
+  struct Interval {
+    std::size_t bp;
+    std::size_t ep;
+    std::size_t k; // Position of the minimum in [bp, ep)
+    uint32_t d; // Document of k
+    bool resolved;
+  };
+
+  /// Pending intervals, used as a stack
+  std::vector<Interval> intervals;
+
+  /// Batch of intervals being resolved
+  std::vector<std::size_t> batch;
+  std::vector<std::size_t> positions;
+  std::vector<uint32_t> docs;
+
+  /// Positions translated by the get document functor (e.g., ILCP runs to suffix array positions)
+  std::vector<std::size_t> sa_positions;
+};
+
+
+/**
+ * Per-query mutable state of the RMQ-based listing schemes.
+ *
+ * The index (RMQ, run heads, document access) is immutable and shared by all threads; everything a query writes to
+ * lives here, so concurrent queries only need distinct contexts.
+ *
+ * @tparam _Reported Set of reported documents (see ReportedTraits)
+ */
+template<typename _Reported>
+struct QueryContext {
+  explicit QueryContext(std::size_t _nd) : reported(ReportedTraits<_Reported>::Build(_nd)) {}
+
+  _Reported reported;
+
+  /// Initial suffix array range of the query (used by ILCP)
+  std::size_t sp = 0;
+  std::size_t ep = 0;
+
+  RMQFrontier frontier;
+
+  /// Documents reported by the query, when needed to reset the reported set
+  std::vector<uint32_t> reported_docs;
+};
+
+
+/**
+ * Thread-safe pool of reusable query contexts.
+ *
+ * Contexts are created on demand and returned to the pool when the handle obtained with Acquire() is destroyed, so
+ * the number of live contexts is bounded by the number of concurrent queries.
+ */
+template<typename _Context>
+class ContextPool {
+ public:
+  using Factory = std::function<std::unique_ptr<_Context>()>;
+
+  explicit ContextPool(Factory _factory) : factory_{std::move(_factory)} {}
+
+  ContextPool(const ContextPool &) = delete;
+  ContextPool &operator=(const ContextPool &) = delete;
+
+  class Release {
+   public:
+    explicit Release(ContextPool *_pool = nullptr) : pool_{_pool} {}
+
+    void operator()(_Context *_context) const {
+      pool_->release(std::unique_ptr<_Context>(_context));
+    }
+
+   private:
+    ContextPool *pool_;
+  };
+
+  using Handle = std::unique_ptr<_Context, Release>;
+
+  Handle Acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_.empty()) {
+        auto context = std::move(free_.back());
+        free_.pop_back();
+        return Handle(context.release(), Release(this));
+      }
+    }
+
+    return Handle(factory_().release(), Release(this));
+  }
+
+  auto size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+  }
+
+ private:
+  void release(std::unique_ptr<_Context> _context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.emplace_back(std::move(_context));
+  }
+
+  Factory factory_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<_Context>> free_;
+};
+
+
+template<typename _Context, typename ..._Args>
+auto BuildContextPool(_Args... _args) {
+  return std::make_unique<ContextPool<_Context>>([_args...]() { return std::make_unique<_Context>(_args...); });
+}
+
+}
+
+#endif //DRL_QUERY_CONTEXT_H
@@ -0,0 +1,244 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_REPORTED_SET_H
+#define DRL_REPORTED_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace drl {
+
+/**
+ * Access to the set of reported documents of a query.
+ *
+ * By default, the set is a random access container with 0/1 values (e.g., sdsl::bit_vector) that must be cleaned
+ * after each query by unsetting the reported documents.
+ */
+template<typename _Reported>
+struct ReportedTraits {
+  /// Reset needs the reported documents
+  static const bool kResetWithDocs = true;
+
+  static _Reported Build(std::size_t _nd) {
+    return _Reported(_nd, 0);
+  }
+
+  /// Prepare the set for a query that will report at most _expected documents
+  static void Prepare(_Reported &_reported, std::size_t _expected) {}
+
+  static bool Test(const _Reported &_reported, std::size_t _d) {
+    return _reported[_d];
+  }
+
+  static void Set(_Reported &_reported, std::size_t _d) {
+    _reported[_d] = 1;
+  }
+
+  /// Empty the set, given the documents reported by the query
+  template<typename _Docs>
+  static void Reset(_Reported &_reported, const _Docs &_docs) {
+    for (const auto &d : _docs) {
+      _reported[d] = 0;
+    }
+  }
+};
+
+
+/// Traits for sets implementing Prepare, Test, Set and Reset (with no arguments) themselves.
+template<typename _Reported>
+struct MemberReportedTraits {
+  static const bool kResetWithDocs = false;
+
+  static _Reported Build(std::size_t _nd) {
+    return _Reported(_nd);
+  }
+
+  static void Prepare(_Reported &_reported, std::size_t _expected) {
+    _reported.Prepare(_expected);
+  }
+
+  static bool Test(const _Reported &_reported, std::size_t _d) {
+    return _reported.Test(_d);
+  }
+
+  static void Set(_Reported &_reported, std::size_t _d) {
+    _reported.Set(_d);
+  }
+
+  template<typename _Docs>
+  static void Reset(_Reported &_reported, const _Docs &_docs) {
+    _reported.Reset();
+  }
+};
+
+
+/**
+ * Reported set with per-slot query stamps.
+ *
+ * A document is reported iff its stamp is the current epoch, so emptying the set only increments the epoch. The
+ * stamps are cleared only when the epoch wraps around (every 2^w - 1 queries for w-bit stamps).
+ */
+template<typename _Stamp = uint16_t>
+class ReportedEpochSet {
+ public:
+  explicit ReportedEpochSet(std::size_t _nd = 0) : stamps_(_nd, 0) {}
+
+  void Prepare(std::size_t _expected) {}
+
+  bool Test(std::size_t _d) const {
+    return stamps_[_d] == epoch_;
+  }
+
+  void Set(std::size_t _d) {
+    stamps_[_d] = epoch_;
+  }
+
+  void Reset() {
+    if (++epoch_ == 0) {
+      std::fill(stamps_.begin(), stamps_.end(), 0);
+      epoch_ = 1;
+    }
+  }
+
+  auto size() const {
+    return stamps_.size();
+  }
+
+ private:
+  std::vector<_Stamp> stamps_;
+  _Stamp epoch_ = 1;
+};
+
+template<typename _Stamp>
+struct ReportedTraits<ReportedEpochSet<_Stamp>> : MemberReportedTraits<ReportedEpochSet<_Stamp>> {};
+
+
+/**
+ * Reported set as an open-addressing hash table (linear probing), for queries reporting few documents.
+ *
+ * The table is sized by Prepare() to twice the expected number of documents, and grows if needed. Emptying the set
+ * only clears the used slots.
+ */
+class ReportedHashSet {
+ public:
+  explicit ReportedHashSet(std::size_t _nd = 0) {}
+
+  void Prepare(std::size_t _expected) {
+    std::size_t capacity = 16;
+    while (capacity < 2 * _expected) capacity <<= 1;
+
+    if (table_.size() < capacity) {
+      table_.assign(capacity, kEmpty);
+      used_.clear();
+    }
+  }
+
+  bool Test(std::size_t _d) const {
+    if (table_.empty()) return false;
+
+    auto mask = table_.size() - 1;
+    for (auto i = Hash(_d) & mask;; i = (i + 1) & mask) {
+      if (table_[i] == _d) return true;
+      if (table_[i] == kEmpty) return false;
+    }
+  }
+
+  void Set(std::size_t _d) {
+    if (table_.size() < 2 * (used_.size() + 1)) Grow();
+
+    auto mask = table_.size() - 1;
+    auto i = Hash(_d) & mask;
+    for (; table_[i] != kEmpty; i = (i + 1) & mask) {
+      if (table_[i] == _d) return;
+    }
+
+    table_[i] = static_cast<uint32_t>(_d);
+    used_.push_back(i);
+  }
+
+  void Reset() {
+    for (const auto &i : used_) {
+      table_[i] = kEmpty;
+    }
+    used_.clear();
+  }
+
+ private:
+  static std::size_t Hash(std::size_t _d) {
+    return (_d * 0x9E3779B97F4A7C15ull) >> 32;
+  }
+
+  void Grow() {
+    std::vector<uint32_t> keys;
+    keys.reserve(used_.size());
+    for (const auto &i : used_) keys.push_back(table_[i]);
+
+    table_.assign(std::max<std::size_t>(16, 2 * table_.size()), kEmpty);
+    used_.clear();
+    for (const auto &d : keys) Set(d);
+  }
+
+  enum : uint32_t { kEmpty = std::numeric_limits<uint32_t>::max() };
+
+  std::vector<uint32_t> table_;
+  std::vector<std::size_t> used_;
+};
+
+template<>
+struct ReportedTraits<ReportedHashSet> : MemberReportedTraits<ReportedHashSet> {};
+
+
+/**
+ * Reported set choosing, per query, between a hash table (few expected documents) and epoch stamps.
+ *
+ * The expected number of documents of a query on [bp, ep) is at most min(nd, ep - bp). When it is small with
+ * respect to nd, the hash table fits in cache whereas the stamps are accessed at random. The stamps are only
+ * allocated the first time they are needed.
+ */
+template<typename _Stamp = uint16_t>
+class ReportedAdaptiveSet {
+ public:
+  explicit ReportedAdaptiveSet(std::size_t _nd = 0, std::size_t _ratio = 16) : nd_{_nd}, ratio_{_ratio} {}
+
+  void Prepare(std::size_t _expected) {
+    use_hash_ = _expected * ratio_ <= nd_;
+
+    if (use_hash_) {
+      hash_.Prepare(_expected);
+    } else if (epoch_.size() != nd_) {
+      epoch_ = ReportedEpochSet<_Stamp>(nd_);
+    }
+  }
+
+  bool Test(std::size_t _d) const {
+    return use_hash_ ? hash_.Test(_d) : epoch_.Test(_d);
+  }
+
+  void Set(std::size_t _d) {
+    use_hash_ ? hash_.Set(_d) : epoch_.Set(_d);
+  }
+
+  void Reset() {
+    use_hash_ ? hash_.Reset() : epoch_.Reset();
+  }
+
+ private:
+  std::size_t nd_;
+  std::size_t ratio_;
+
+  bool use_hash_ = true;
+  ReportedHashSet hash_;
+  ReportedEpochSet<_Stamp> epoch_;
+};
+
+template<typename _Stamp>
+struct ReportedTraits<ReportedAdaptiveSet<_Stamp>> : MemberReportedTraits<ReportedAdaptiveSet<_Stamp>> {};
+
+}
+
+#endif //DRL_REPORTED_SET_H
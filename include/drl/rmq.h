@@ -0,0 +1,311 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_RMQ_H
+#define DRL_RMQ_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <utility>
+#include <type_traits>
+
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/rmq_support.hpp>
+
+namespace drl {
+
+/**
+ * RMQ concept: a const call rmq(i, j) returns the position of a minimum in [i, j] (inclusive).
+ *
+ * Optionally, rmq.prefetch(i, j) starts loading the memory needed by the query (see PrefetchRMQ).
+ */
+template<typename _RMQ, typename = void>
+struct IsRMQ : std::false_type {};
+
+template<typename _RMQ>
+struct IsRMQ<_RMQ, decltype(std::declval<const _RMQ &>()(std::size_t{}, std::size_t{}), void())>
+    : std::is_convertible<decltype(std::declval<const _RMQ &>()(std::size_t{}, std::size_t{})), std::size_t> {};
+
+
+/**
+ * Prefetch the structures used by the RMQ to answer a query on [_i, _j].
+ *
+ * RMQs that know where their query data lives can expose it with a method prefetch(i, j); otherwise it is a no-op.
+ */
+template<typename _RMQ>
+auto PrefetchRMQ(const _RMQ &_rmq, std::size_t _i, std::size_t _j, int) -> decltype(_rmq.prefetch(_i, _j), void()) {
+  _rmq.prefetch(_i, _j);
+}
+
+template<typename _RMQ>
+void PrefetchRMQ(const _RMQ &_rmq, std::size_t _i, std::size_t _j, long) {}
+
+template<typename _RMQ>
+void PrefetchRMQ(const _RMQ &_rmq, std::size_t _i, std::size_t _j) {
+  PrefetchRMQ(_rmq, _i, _j, 0);
+}
+
+
+typedef sdsl::rmq_succinct_sct<true, sdsl::bp_support_sada<256, 32, sdsl::rank_support_v5<>>> DefaultRMQ;
+
+
+/**
+ * Position of the leftmost minimum in _values[_i.._j].
+ */
+template<typename _Values>
+std::size_t ScanMin(const _Values &_values, std::size_t _i, std::size_t _j) {
+  auto k = _i;
+  auto min = _values[_i];
+  for (auto l = _i + 1; l <= _j; ++l) {
+    auto value = _values[l];
+    if (value < min) {
+      min = value;
+      k = l;
+    }
+  }
+
+  return k;
+}
+
+/**
+ * Position of the leftmost minimum in _values[_i.._j], using SSE4.1 (when available) to compute the minimum and
+ * then to find its first occurrence.
+ */
+inline std::size_t ScanMin(const std::vector<uint32_t> &_values, std::size_t _i, std::size_t _j) {
+#ifdef __SSE4_1__
+  if (_j - _i + 1 >= 8) {
+    const uint32_t *data = _values.data();
+    auto end = _j + 1;
+
+    auto k = _i;
+    __m128i mins = _mm_set1_epi32(-1);
+    for (; k + 4 <= end; k += 4) {
+      mins = _mm_min_epu32(mins, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + k)));
+    }
+    mins = _mm_min_epu32(mins, _mm_shuffle_epi32(mins, _MM_SHUFFLE(1, 0, 3, 2)));
+    mins = _mm_min_epu32(mins, _mm_shuffle_epi32(mins, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    auto min = static_cast<uint32_t>(_mm_cvtsi128_si32(mins));
+    for (; k < end; ++k) {
+      if (data[k] < min) min = data[k];
+    }
+
+    const __m128i target = _mm_set1_epi32(min);
+    for (k = _i; k + 4 <= end; k += 4) {
+      auto eq = _mm_cmpeq_epi32(target, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + k)));
+      auto mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+      if (mask) return k + __builtin_ctz(mask);
+    }
+    while (data[k] != min) ++k;
+
+    return k;
+  }
+#endif
+
+  return ScanMin<std::vector<uint32_t>>(_values, _i, _j);
+}
+
+
+/// Copy values into the storage of a block RMQ (bit-compressed for sdsl::int_vector<>)
+template<typename _Container>
+void AssignValues(sdsl::int_vector<> &_values, const _Container &_container) {
+  _values = sdsl::int_vector<>(_container.size(), 0, 64);
+  for (std::size_t i = 0; i < _container.size(); ++i) _values[i] = _container[i];
+  sdsl::util::bit_compress(_values);
+}
+
+/// Copy values into 32-bit storage; throws std::out_of_range instead of truncating values that do not fit
+template<typename _Container>
+void AssignValues(std::vector<uint32_t> &_values, const _Container &_container) {
+  _values.clear();
+  _values.reserve(_container.size());
+  for (std::size_t i = 0; i < _container.size(); ++i) {
+    uint64_t value = _container[i];
+    if (value > std::numeric_limits<uint32_t>::max())
+      throw std::out_of_range("AssignValues: value " + std::to_string(value) + " does not fit in 32 bits");
+    _values.push_back(static_cast<uint32_t>(value));
+  }
+}
+
+
+/// Address of the value at position _i (for prefetching)
+inline const void *ValueAddress(const sdsl::int_vector<> &_values, std::size_t _i) {
+  return _values.data() + ((_i * _values.width()) >> 6);
+}
+
+inline const void *ValueAddress(const std::vector<uint32_t> &_values, std::size_t _i) {
+  return _values.data() + _i;
+}
+
+
+/**
+ * Block-decomposed RMQ.
+ *
+ * The values are split in blocks of _BlockSize. Each block stores its minimum (value and offset) in compact arrays,
+ * and a sparse table over the block minima answers the queries spanning whole blocks. The partial blocks at the ends
+ * of a query are scanned sequentially, so a query touches at most two blocks of values, two entries of the sparse
+ * table and their block minima. It takes more space than a succinct RMQ but fewer and more predictable memory
+ * accesses.
+ *
+ * The answer is the leftmost minimum in the range.
+ *
+ * @tparam _Values Storage of the values: sdsl::int_vector<> (bit-compressed, scalar scans) or std::vector<uint32_t>
+ *                 (32-bit values, SIMD scans with SSE4.1; the constructor throws std::out_of_range if a value does
+ *                 not fit in 32 bits)
+ * @tparam _BlockSize Values per block (at most 256)
+ */
+template<typename _Values, std::size_t _BlockSize = 64>
+class BlockRMQ {
+  static_assert(0 < _BlockSize && _BlockSize <= 256, "Block offsets must fit in 8 bits");
+
+ public:
+  typedef std::size_t size_type;
+
+  BlockRMQ() = default;
+
+  template<typename _Container>
+  explicit BlockRMQ(const _Container *_container) {
+    if (_container == nullptr) return;
+
+    AssignValues(values_, *_container);
+    auto n = values_.size();
+    auto n_blocks = (n + _BlockSize - 1) / _BlockSize;
+
+    // Block minima
+    std::vector<uint64_t> mins(n_blocks);
+    block_offsets_.resize(n_blocks);
+    for (size_type b = 0; b < n_blocks; ++b) {
+      auto bp = b * _BlockSize;
+      auto k = ScanMin(values_, bp, std::min(bp + _BlockSize, n) - 1);
+      mins[b] = values_[k];
+      block_offsets_[b] = static_cast<uint8_t>(k - bp);
+    }
+    AssignValues(block_mins_, mins);
+
+    // Sparse table over the blocks: level l > 0 stores the leftmost minimum block of [b, b + 2^l)
+    computeLevelOffsets();
+    table_ = sdsl::int_vector<>(level_offsets_.back(), 0, sdsl::bits::hi(std::max<size_type>(n_blocks, 1)) + 1);
+    for (size_type l = 1; l + 1 < level_offsets_.size(); ++l) {
+      auto half = size_type(1) << (l - 1);
+      for (size_type b = 0; b + 2 * half <= n_blocks; ++b) {
+        size_type left = b, right = b + 1;
+        if (l > 1) {
+          left = table_[level_offsets_[l - 1] + b];
+          right = table_[level_offsets_[l - 1] + b + half];
+        }
+        table_[level_offsets_[l] + b] = (block_mins_[right] < block_mins_[left]) ? right : left;
+      }
+    }
+  }
+
+  /**
+   * Position of the leftmost minimum in [_i, _j].
+   */
+  size_type operator()(size_type _i, size_type _j) const {
+    auto bi = _i / _BlockSize, bj = _j / _BlockSize;
+    if (bi == bj) return ScanMin(values_, _i, _j);
+
+    auto k = ScanMin(values_, _i, (bi + 1) * _BlockSize - 1);
+    auto min = values_[k];
+
+    if (bi + 1 < bj) {
+      auto b = minBlock(bi + 1, bj - 1);
+      if (block_mins_[b] < min) {
+        k = b * _BlockSize + block_offsets_[b];
+        min = block_mins_[b];
+      }
+    }
+
+    auto k_right = ScanMin(values_, bj * _BlockSize, _j);
+    if (values_[k_right] < min) k = k_right;
+
+    return k;
+  }
+
+  /**
+   * Prefetch the partial blocks at the ends of [_i, _j] and the block minima between them.
+   */
+  void prefetch(size_type _i, size_type _j) const {
+#if defined(__GNUC__)
+    __builtin_prefetch(ValueAddress(values_, _i));
+    __builtin_prefetch(ValueAddress(values_, _j));
+    __builtin_prefetch(ValueAddress(block_mins_, _i / _BlockSize));
+    __builtin_prefetch(ValueAddress(block_mins_, _j / _BlockSize));
+#endif
+  }
+
+  size_type size() const {
+    return values_.size();
+  }
+
+  size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, const std::string &name = "") const {
+    auto child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+
+    size_type written_bytes = 0;
+    written_bytes += sdsl::serialize(values_, out, child, "values");
+    written_bytes += sdsl::serialize(block_mins_, out, child, "block_mins");
+    written_bytes += sdsl::serialize(block_offsets_, out, child, "block_offsets");
+    written_bytes += sdsl::serialize(table_, out, child, "table");
+
+    sdsl::structure_tree::add_size(child, written_bytes);
+
+    return written_bytes;
+  }
+
+  void load(std::istream &in) {
+    sdsl::load(values_, in);
+    sdsl::load(block_mins_, in);
+    sdsl::load(block_offsets_, in);
+    sdsl::load(table_, in);
+
+    computeLevelOffsets();
+  }
+
+ private:
+  /// Offsets of the levels in the table; level l > 0 has n_blocks - 2^l + 1 entries and the last offset is the size
+  void computeLevelOffsets() {
+    auto n_blocks = block_offsets_.size();
+
+    level_offsets_.assign(2, 0);
+    for (size_type l = 1; (size_type(1) << l) <= n_blocks; ++l) {
+      level_offsets_.push_back(level_offsets_.back() + n_blocks - (size_type(1) << l) + 1);
+    }
+  }
+
+  /// Leftmost minimum block in [_bi, _bj]
+  size_type minBlock(size_type _bi, size_type _bj) const {
+    auto l = sdsl::bits::hi(_bj - _bi + 1);
+    if (l == 0) return _bi;
+
+    size_type left = table_[level_offsets_[l] + _bi];
+    size_type right = table_[level_offsets_[l] + _bj - (size_type(1) << l) + 1];
+
+    return (block_mins_[right] < block_mins_[left]) ? right : left;
+  }
+
+  _Values values_;
+  _Values block_mins_;
+  std::vector<uint8_t> block_offsets_;
+  sdsl::int_vector<> table_; // Levels of the sparse table (l > 0) concatenated
+  std::vector<size_type> level_offsets_;
+};
+
+
+/// Block RMQ on bit-compressed values with scalar in-block scans
+typedef BlockRMQ<sdsl::int_vector<>> CompactBlockRMQ;
+
+/// Block RMQ on 32-bit values with SIMD in-block scans (scalar if SSE4.1 is not enabled)
+typedef BlockRMQ<std::vector<uint32_t>> SIMDBlockRMQ;
+
+}
+
+#endif //DRL_RMQ_H
@@ -0,0 +1,164 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_RULE_CACHE_H
+#define DRL_RULE_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace drl {
+
+/**
+ * Bounded cache of grammar rule expansions, shared by the threads answering queries.
+ *
+ * Each cached rule stores its full expansion as a flat array of documents. The rules are spread over shards by
+ * identifier; a lookup takes the shared lock of its shard, and only insertions take it exclusively. When a shard is
+ * full, its entries are evicted in CLOCK order: an entry read since the last pass of the hand gets a second chance.
+ * Expansions shorter than the minimum length are cheaper to decompress than to look up, so they are not admitted.
+ * The rules that were not admitted are remembered in a small direct-mapped table, so that looking them up again takes
+ * no lock and does not count as a miss.
+ */
+class RuleCache {
+ public:
+  /**
+   * @param _capacity Maximum size of the cached expansions in bytes
+   * @param _min_length Minimum length of the admitted expansions
+   * @param _shards Number of shards
+   */
+  explicit RuleCache(std::size_t _capacity, std::size_t _min_length = 16, std::size_t _shards = 16)
+      : shards_(_shards > 0 ? _shards : 1), min_length_{_min_length}, rejected_(kRejectedSlots) {
+    shard_capacity_ = _capacity / shards_.size();
+  }
+
+  RuleCache(const RuleCache &) = delete;
+  RuleCache &operator=(const RuleCache &) = delete;
+
+  /**
+   * Report the expansion of a rule if it is cached.
+   *
+   * @return True if the rule was found
+   */
+  template<typename _Report>
+  bool report(std::size_t _rule, _Report &_report) const {
+    if (isRejected(_rule)) return false;
+
+    auto &shard = getShard(_rule);
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(_rule);
+    if (it == shard.entries.end()) {
+      shard.misses.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+
+    it->second.referenced.store(true, std::memory_order_relaxed);
+    for (const auto &d : it->second.docs) {
+      _report(d);
+    }
+
+    return true;
+  }
+
+  /// Insert the expansion [_first, _last) of a rule, evicting older entries if needed
+  template<typename _II>
+  void insert(std::size_t _rule, _II _first, _II _last) {
+    std::size_t length = std::distance(_first, _last);
+    std::size_t bytes = length * sizeof(uint32_t);
+    if (length < min_length_ || bytes > shard_capacity_) {
+      rejected_[_rule % kRejectedSlots].store(_rule + 1, std::memory_order_relaxed);
+      return;
+    }
+
+    auto &shard = getShard(_rule);
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+    if (shard.entries.count(_rule)) return;  // Inserted by another thread.
+
+    while (shard.bytes + bytes > shard_capacity_ && !shard.clock.empty()) {
+      if (shard.hand >= shard.clock.size()) shard.hand = 0;
+
+      auto &entry = shard.entries.at(shard.clock[shard.hand]);
+      if (entry.referenced.exchange(false, std::memory_order_relaxed)) {
+        ++shard.hand;
+        continue;
+      }
+
+      shard.bytes -= entry.docs.size() * sizeof(uint32_t);
+      shard.entries.erase(shard.clock[shard.hand]);
+      shard.clock[shard.hand] = shard.clock.back();
+      shard.clock.pop_back();
+    }
+
+    shard.entries[_rule].docs.assign(_first, _last);
+    shard.clock.emplace_back(_rule);
+    shard.bytes += bytes;
+  }
+
+  std::size_t hits() const {
+    std::size_t total = 0;
+    for (const auto &shard : shards_) total += shard.hits.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  std::size_t misses() const {
+    std::size_t total = 0;
+    for (const auto &shard : shards_) total += shard.misses.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  /// Size of the cached expansions in bytes
+  std::size_t size() const {
+    std::size_t total = 0;
+    for (const auto &shard : shards_) {
+      std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+      total += shard.bytes;
+    }
+    return total;
+  }
+
+ private:
+  struct Entry {
+    std::vector<uint32_t> docs;
+    std::atomic<bool> referenced{false};
+  };
+
+  struct Shard {
+    mutable std::shared_timed_mutex mutex;
+    std::unordered_map<std::size_t, Entry> entries;
+    std::vector<std::size_t> clock;  // Cached rules in CLOCK order
+    std::size_t hand = 0;
+    std::size_t bytes = 0;
+
+    mutable std::atomic<std::size_t> hits{0};
+    mutable std::atomic<std::size_t> misses{0};
+  };
+
+  Shard &getShard(std::size_t _rule) const {
+    return shards_[_rule % shards_.size()];
+  }
+
+  bool isRejected(std::size_t _rule) const {
+    return rejected_[_rule % kRejectedSlots].load(std::memory_order_relaxed) == _rule + 1;
+  }
+
+  static const std::size_t kRejectedSlots = 1u << 14;
+
+  mutable std::vector<Shard> shards_;
+  std::size_t shard_capacity_;
+  std::size_t min_length_;
+
+  // Rules not admitted by insert() (plus one), by identifier modulo the number of slots
+  std::vector<std::atomic<std::size_t>> rejected_;
+};
+
+}
+
+#endif //DRL_RULE_CACHE_H
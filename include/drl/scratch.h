@@ -0,0 +1,123 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_SCRATCH_H
+#define DRL_SCRATCH_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace drl {
+
+/**
+ * Scratch array for construction, stored in memory or in a memory-mapped temporary file.
+ *
+ * The file is created in the given directory and unlinked at once, so it is removed when the array is destroyed or the
+ * process ends. The kernel writes the pages of a mapped array back to the file under memory pressure, so arrays larger
+ * than the available memory can be processed with sequential passes.
+ *
+ * @tparam _T Trivially copyable element type
+ */
+template<typename _T>
+class ScratchArray {
+ public:
+  ScratchArray() = default;
+
+  /**
+   * @param _size Number of elements
+   * @param _mapped If true, use a temporary file in _temp_dir; if it cannot be mapped, the array falls back to memory
+   * @param _temp_dir Directory for the temporary file
+   */
+  ScratchArray(std::size_t _size, bool _mapped, const std::string &_temp_dir = "/tmp") : size_{_size} {
+    if (_mapped && size_ > 0) map(_temp_dir);
+    if (data_ == nullptr) {
+      memory_.resize(size_);
+      data_ = memory_.data();
+    }
+  }
+
+  ~ScratchArray() {
+    unmap();
+  }
+
+  ScratchArray(const ScratchArray &) = delete;
+  ScratchArray &operator=(const ScratchArray &) = delete;
+
+  _T *data() { return data_; }
+  const _T *data() const { return data_; }
+
+  _T &operator[](std::size_t _i) { return data_[_i]; }
+  const _T &operator[](std::size_t _i) const { return data_[_i]; }
+
+  std::size_t size() const { return size_; }
+
+  bool isMapped() const { return mapped_; }
+
+  /// The array will be accessed sequentially (more read-ahead, earlier reclaim)
+  void adviseSequential() {
+    if (mapped_) madvise(data_, bytes(), MADV_SEQUENTIAL);
+  }
+
+  /// The array will be accessed at random
+  void adviseRandom() {
+    if (mapped_) madvise(data_, bytes(), MADV_RANDOM);
+  }
+
+  /// Drop the resident pages of a mapped array after a pass; the contents stay in the file
+  void release() {
+    if (mapped_) madvise(data_, bytes(), MADV_DONTNEED);
+  }
+
+  /// Free the array
+  void clear() {
+    unmap();
+    std::vector<_T>().swap(memory_);
+    size_ = 0;
+  }
+
+ private:
+  std::size_t bytes() const {
+    return size_ * sizeof(_T);
+  }
+
+  void map(const std::string &_temp_dir) {
+    std::string name = _temp_dir + "/drl_scratch_XXXXXX";
+    std::vector<char> path(name.begin(), name.end());
+    path.push_back('\0');
+
+    int fd = mkstemp(path.data());
+    if (fd < 0) return;
+    unlink(path.data());
+
+    if (ftruncate(fd, bytes()) == 0) {
+      void *addr = mmap(nullptr, bytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (addr != MAP_FAILED) {
+        data_ = static_cast<_T *>(addr);
+        mapped_ = true;
+      }
+    }
+    close(fd);
+  }
+
+  void unmap() {
+    if (mapped_) munmap(data_, bytes());
+    mapped_ = false;
+    data_ = nullptr;
+  }
+
+  std::size_t size_ = 0;
+  _T *data_ = nullptr;
+  bool mapped_ = false;
+  std::vector<_T> memory_;
+};
+
+}
+
+#endif //DRL_SCRATCH_H
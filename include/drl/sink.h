@@ -0,0 +1,77 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#ifndef DRL_SINK_H
+#define DRL_SINK_H
+
+#include <cstddef>
+#include <limits>
+
+namespace drl {
+
+const std::size_t kNoLimit = std::numeric_limits<std::size_t>::max();
+
+/// Initial capacity of the set of emitted documents when streaming results without repetitions
+const std::size_t kSeenDocsInitialSize = 1u << 12;
+
+
+/**
+ * Emit a document to a sink, which is either a callable (sink(d)) or an output iterator (*sink++ = d).
+ */
+template<typename _Sink, typename _Doc>
+auto EmitDoc(_Sink &_sink, const _Doc &_d, int) -> decltype(_sink(_d), void()) {
+  _sink(_d);
+}
+
+template<typename _Sink, typename _Doc>
+void EmitDoc(_Sink &_sink, const _Doc &_d, long) {
+  *_sink = _d;
+  ++_sink;
+}
+
+template<typename _Sink, typename _Doc>
+void EmitDoc(_Sink &_sink, const _Doc &_d) {
+  EmitDoc(_sink, _d, 0);
+}
+
+
+/**
+ * Sink that forwards at most limit documents; the rest are dropped.
+ */
+template<typename _Sink>
+class LimitedSink {
+ public:
+  LimitedSink(_Sink &_sink, std::size_t _limit) : sink_{_sink}, limit_{_limit} {}
+
+  template<typename _Doc>
+  void operator()(const _Doc &_d) {
+    if (count_ < limit_) {
+      EmitDoc(sink_, _d);
+      ++count_;
+    }
+  }
+
+  bool full() const {
+    return limit_ <= count_;
+  }
+
+  std::size_t count() const {
+    return count_;
+  }
+
+ private:
+  _Sink &sink_;
+  std::size_t limit_;
+  std::size_t count_ = 0;
+};
+
+
+template<typename _Sink>
+auto BuildLimitedSink(_Sink &_sink, std::size_t _limit) {
+  return LimitedSink<_Sink>(_sink, _limit);
+}
+
+}
+
+#endif //DRL_SINK_H
@@ -72,6 +72,13 @@ void sortById(std::vector<Document>* docs);
 // Sorting by (freq, id) is used for PDL-topk construction.
 void sortByFrequency(std::vector<Document>* docs);
 
+// Keep the k most frequent documents in the order of sortByFrequency.
+// This uses selection instead of sorting all documents. It works on Document
+// rather than ScoredDoc (sortByScore uses the same order): the frequencies are
+// integers, the results are returned as Document, and a ScoredDoc is three
+// times larger, which matters when selecting among millions of documents.
+void selectMostFrequent(std::vector<Document>* docs, usint k);
+
 // Merge runs of identical documents.
 void mergeDocumentRuns(std::vector<Document>* docs);
 
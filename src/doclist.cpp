@@ -1,16 +1,22 @@
+#include <algorithm>
 #include <iostream>
-#include <stack>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <sdsl/bit_vectors.hpp>
 
 #include "drl/doclist.h"
+#include "drl/dedup.h"
 
 //--------------------------------------------------------------------------
 
 const std::string Doclist::DOCARRAY_EXTENSION = ".docs";
+const std::string Doclist::COUNTER_EXTENSION = ".docc";
 
 Doclist::Doclist(const RLCSA& _rlcsa) :
-  rlcsa(_rlcsa), docarray(0), rmq(0), status(_rlcsa.isOk() ? st_unfinished : st_error)
+  rlcsa(_rlcsa), docarray(0), rmq(0), counter(0), status(_rlcsa.isOk() ? st_unfinished : st_error)
 {
 }
 
@@ -18,6 +24,7 @@ Doclist::~Doclist()
 {
   delete this->docarray; this->docarray = 0;
   delete this->rmq; this->rmq = 0;
+  delete this->counter; this->counter = 0;
 }
 
 Doclist::result_type*
@@ -36,37 +43,97 @@ Doclist::listDocuments(pair_type range, found_type* found) const
   return this->listUnsafe(range, found);
 }
 
+bool
+Doclist::listDocuments(const std::string& pattern, result_type& results, found_type* found) const
+{
+  results.clear();
+  if(!(this->isOk())) { return false; }
+  pair_type range = this->rlcsa.count(pattern);
+  if(CSA::isEmpty(range)) { return false; }
+  this->listUnsafe(range, found, results);
+  return true;
+}
+
+bool
+Doclist::listDocuments(pair_type range, result_type& results, found_type* found) const
+{
+  results.clear();
+  if(!(this->isOk()) || CSA::isEmpty(range) || range.second >= this->rlcsa.getSize()) { return false; }
+  this->listUnsafe(range, found, results);
+  return true;
+}
+
+namespace
+{
+
+// Per-thread buffers for the queries: the found buffer, which is empty between the
+// queries, and the stack of RMQ intervals. The found buffer grows to the largest
+// number of documents seen by the thread.
+class QueryBuffers
+{
+  public:
+    QueryBuffers() : found(0), found_size(0) {}
+    ~QueryBuffers() { delete this->found; this->found = 0; }
+
+    Doclist::found_type* getFound(usint size)
+    {
+      if(this->found == 0 || this->found_size < size)
+      {
+        delete this->found;
+        this->found = new Doclist::found_type(size, 1);
+        this->found_size = size;
+      }
+      return this->found;
+    }
+
+    std::vector<pair_type> intervals;
+
+  private:
+    Doclist::found_type* found;
+    usint                found_size;
+
+    // These are not allowed.
+    QueryBuffers(const QueryBuffers&);
+    QueryBuffers& operator = (const QueryBuffers&);
+};
+
+thread_local QueryBuffers query_buffers;
+
+}
+
 Doclist::result_type*
 Doclist::listUnsafe(pair_type range, found_type* found) const
 {
-  bool delete_found = (found == 0);
-  if(delete_found) { found = new found_type(this->rlcsa.getNumberOfSequences(), 1); }
-
-  std::stack<pair_type> intervals; intervals.push(this->getRMQRange(range));
   result_type* results = new result_type;
+  this->listUnsafe(range, found, *results);
+  return results;
+}
+
+void
+Doclist::listUnsafe(pair_type range, found_type* found, result_type& results) const
+{
+  if(found == 0) { found = query_buffers.getFound(this->rlcsa.getNumberOfSequences()); }
+
+  std::vector<pair_type>& intervals = query_buffers.intervals;
+  intervals.clear(); intervals.push_back(this->getRMQRange(range));
   while(!(intervals.empty()))
   {
-    pair_type current = intervals.top(); intervals.pop();
+    pair_type current = intervals.back(); intervals.pop_back();
     usint min_pos = (*(this->rmq))(current.first, current.second);
     usint doc = this->docAt(min_pos, range);
     if(!(found->isSet(doc)))
     {
-      this->addDocs(doc, min_pos, results, found, range);
-      if(min_pos < current.second) { intervals.push(pair_type(min_pos + 1, current.second)); }
-      if(min_pos > current.first)  { intervals.push(pair_type(current.first, min_pos - 1)); }
+      this->addDocs(doc, min_pos, &results, found, range);
+      if(min_pos < current.second) { intervals.push_back(pair_type(min_pos + 1, current.second)); }
+      if(min_pos > current.first)  { intervals.push_back(pair_type(current.first, min_pos - 1)); }
     }
   }
 
-  CSA::sequentialSort(results->begin(), results->end());
-  if(delete_found) { delete found; found = 0; }
-  else
+  drl::Dedup(results);
+  for(result_type::iterator iter = results.begin(); iter != results.end(); ++iter)
   {
-    for(result_type::iterator iter = results->begin(); iter != results->end(); ++iter)
-    {
-      found->unsetBit(*iter);
-    }
+    found->unsetBit(*iter);
   }
-  return results;
 }
 
 Doclist::result_type*
@@ -104,16 +171,39 @@ Doclist::listUnsafeBrute(pair_type range) const
     buffer = this->rlcsa.getSequenceForPosition(this->rlcsa.locate(range, buffer), CSA::length(range));
   }
 
-  CSA::removeDuplicates(results, false);
+  drl::Dedup(*results);
   return results;
 }
 
+usint
+Doclist::countDocuments(const std::string& pattern) const
+{
+  if(!(this->isOk())) { return 0; }
+  pair_type range = this->rlcsa.count(pattern);
+  if(CSA::isEmpty(range)) { return 0; }
+  return this->countDocuments(range);
+}
+
+usint
+Doclist::countDocuments(pair_type range) const
+{
+  if(!(this->isOk()) || CSA::isEmpty(range) || range.second >= this->rlcsa.getSize()) { return 0; }
+  if(this->hasCounter()) { return this->counter->count(range.first, range.second + 1); }
+
+  thread_local result_type results;
+  this->listUnsafe(range, 0, results);
+  usint docc = results.size();
+  results.clear();
+  return docc;
+}
+
 usint
 Doclist::commonStructureSize() const
 {
   usint bytes = 0;
   if(this->rmq != 0) { bytes += size_in_bytes(*(this->rmq)); }
   if(this->docarray != 0) { bytes += this->docarray->reportSize(); }
+  if(this->counter != 0) { bytes += sdsl::size_in_bytes(*(this->counter)); }
   return bytes;
 }
 
@@ -179,11 +269,41 @@ Doclist::writeDocs(std::ofstream& output) const
   this->docarray->writeBuffer(output);
 }
 
+void
+Doclist::readCounter(const std::string& base_name)
+{
+  if(!(this->isOk())) { return; }
+
+  delete this->counter; this->counter = 0;
+  std::string counter_name = base_name + COUNTER_EXTENSION;
+  std::ifstream input(counter_name.c_str(), std::ios_base::binary);
+  if(input)
+  {
+    this->counter = new drl::DocCounter;
+    this->counter->load(input);
+    input.close();
+  }
+}
+
+void
+Doclist::writeCounter(const std::string& base_name) const
+{
+  if(!(this->isOk()) || this->counter == 0) { return; }
+
+  std::string counter_name = base_name + COUNTER_EXTENSION;
+  std::ofstream output(counter_name.c_str(), std::ios_base::binary);
+  if(output)
+  {
+    this->counter->serialize(output);
+    output.close();
+  }
+}
+
 //--------------------------------------------------------------------------
 
 const std::string DoclistSada::EXTENSION = ".sada";
 
-DoclistSada::DoclistSada(const RLCSA& _rlcsa, bool store_docarray) :
+DoclistSada::DoclistSada(const RLCSA& _rlcsa, bool store_docarray, bool build_counter) :
   Doclist(_rlcsa)
 {
   if(this->status != st_unfinished || !(this->rlcsa.supportsLocate())) { return; }
@@ -191,7 +311,8 @@ DoclistSada::DoclistSada(const RLCSA& _rlcsa, bool store_docarray) :
   // Build the C array and store the D array.
   usint* prev = new usint[this->rlcsa.getNumberOfSequences()];
   for(usint i = 0; i < this->rlcsa.getNumberOfSequences(); i++) { prev[i] = 0; }
-  sdsl::int_vector<64> c_array(this->rlcsa.getSize());
+  // C[i] <= i, so the C array is bit-compressed from the start.
+  sdsl::int_vector<> c_array(this->rlcsa.getSize(), 0, std::max((usint)1, CSA::length(this->rlcsa.getSize())));
   CSA::WriteBuffer* buffer = 0;
   if(store_docarray)
   {
@@ -199,10 +320,28 @@ DoclistSada::DoclistSada(const RLCSA& _rlcsa, bool store_docarray) :
     buffer = new CSA::WriteBuffer(this->rlcsa.getSize(), item_bits);
   }
 
+  // The LCP array is only needed for the document counter.
+  sdsl::int_vector<32> lcp;
+  CSA::PLCPVector* plcpvec = 0;
+  CSA::PLCPVector::Iterator* plcp_iter = 0;
+  if(build_counter)
+  {
+    lcp.resize(this->rlcsa.getSize());
+    plcpvec = this->rlcsa.buildPLCP(16);
+    plcp_iter = new CSA::PLCPVector::Iterator(*plcpvec);
+  }
+
   for(usint i = 0; i < this->rlcsa.getSize(); i += BLOCK_SIZE)
   {
     pair_type range(i, std::min(i + BLOCK_SIZE, this->rlcsa.getSize()) - 1);
     usint* docs = this->rlcsa.locate(range);
+    if(build_counter)
+    {
+      for(usint j = range.first; j <= range.second; j++)
+      {
+        lcp[j] = plcp_iter->select(docs[j - i]) - 2 * docs[j - i];
+      }
+    }
     this->rlcsa.getSequenceForPosition(docs, CSA::length(range));
     for(usint j = range.first; j <= range.second; j++)
     {
@@ -218,6 +357,15 @@ DoclistSada::DoclistSada(const RLCSA& _rlcsa, bool store_docarray) :
     delete buffer; buffer = 0;
   }
   delete[] prev; prev = 0;
+  delete plcp_iter; plcp_iter = 0;
+  delete plcpvec; plcpvec = 0;
+
+  // Build the document counter.
+  if(build_counter)
+  {
+    this->counter = new drl::DocCounter(c_array, lcp);
+    sdsl::util::clear(lcp);
+  }
 
   // Build the RMQ.
   this->rmq = new RMQType(&c_array);
@@ -225,7 +373,7 @@ DoclistSada::DoclistSada(const RLCSA& _rlcsa, bool store_docarray) :
   this->status = st_ok;
 }
 
-DoclistSada::DoclistSada(const RLCSA& _rlcsa, const std::string& base_name, bool load_docarray) :
+DoclistSada::DoclistSada(const RLCSA& _rlcsa, const std::string& base_name, bool load_docarray, bool load_counter) :
   Doclist(_rlcsa)
 {
   if(this->status != st_unfinished || !(this->rlcsa.supportsLocate())) { return; }
@@ -236,6 +384,7 @@ DoclistSada::DoclistSada(const RLCSA& _rlcsa, const std::string& base_name, bool
   {
     this->loadFrom(input);
     if(load_docarray) { this->readDocs(base_name); }
+    if(load_counter) { this->readCounter(base_name); }
     input.close();
   }
 }
@@ -262,6 +411,7 @@ DoclistSada::writeTo(const std::string& base_name) const
   {
     this->writeRMQ(output);
     this->writeDocs(base_name);
+    this->writeCounter(base_name);
     output.close();
   }
 }
@@ -322,42 +472,102 @@ DoclistILCP::DoclistILCP(const RLCSA& _rlcsa) :
 {
   if(this->status != st_unfinished || !(this->rlcsa.supportsLocate())) { return; }
 
-  // Build ILCP
-  uint* iLCP = new uint[this->rlcsa.getSize()];
-  for(usint i = 0; i < this->rlcsa.getNumberOfSequences(); i++)
+  // Build RMQ for the run heads
+  sdsl::int_vector<32> heads = buildRunHeads(this->rlcsa, &(this->run_heads));
+  this->rmq = new RMQType(&heads);
+
+  this->status = st_ok;
+}
+
+sdsl::int_vector<32>
+DoclistILCP::buildRunHeads(const RLCSA& rlcsa, CSA::DeltaVector** run_heads)
+{
+  usint size = rlcsa.getSize(), docs = rlcsa.getNumberOfSequences();
+  if(size == 0 || docs == 0) { return sdsl::int_vector<32>(0); }
+
+  // RLCSA starts each document at a multiple of the sample rate, so the text positions have gaps.
+  // The PLCP values are stored in gap-free coordinates: position p of document i becomes
+  // offsets[i] + p - starts[i], where offsets[i] is the total length of the previous documents.
+  std::vector<usint> starts(docs), offsets(docs + 1, 0);
+  for(usint i = 0; i < docs; i++)
   {
-    CSA::SuffixArray* sa = this->rlcsa.getSuffixArrayForSequence(i);
+    pair_type range = rlcsa.getSequenceRange(i);
+    starts[i] = range.first;
+    offsets[i + 1] = offsets[i] + CSA::length(range);
+  }
+
+  // Build the PLCP arrays of the documents in parallel. They are stored as in the
+  // PLCPVector: PLCP[j] + j is non-decreasing within a document and bounded by the
+  // document length, so gap-free position g of a document is encoded as bit PLCP + 2g.
+  // The gap-free positions are contiguous, so the value of position g is select(g + 1) - 2g.
+  // The documents use disjoint ranges of bits, and only the words at the borders of the
+  // ranges are shared between threads.
+  sdsl::bit_vector plcp_bits(2 * offsets[docs], 0);
+  uint64_t* words = plcp_bits.data();
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint i = 0; i < docs; i++)
+  {
+    CSA::SuffixArray* sa = rlcsa.getSuffixArrayForSequence(i);
     uint* plcp = sa->getLCPArray(true);
-    for(usint j = 0; j < sa->getSize(); j++)
+    usint start = offsets[i], len = sa->getSize();
+    usint first_word = (2 * start) / CSA::WORD_BITS, last_word = (2 * (start + len) - 1) / CSA::WORD_BITS;
+    for(usint j = 0; j < len; j++)
     {
-      iLCP[sa->getRanks()[j] - this->rlcsa.getNumberOfSequences()] = plcp[j];
+      usint bit = plcp[j] + 2 * (start + j), word = bit / CSA::WORD_BITS;
+      uint64_t mask = ((uint64_t)1) << (bit % CSA::WORD_BITS);
+      if(word == first_word || word == last_word) { __atomic_fetch_or(words + word, mask, __ATOMIC_RELAXED); }
+      else { words[word] |= mask; }
     }
     delete[] plcp; plcp = 0;
     delete sa; sa = 0;
   }
-
-  // Count run heads
-  usint n_run_heads = 1;
-  for(usint i = 1; i < this->rlcsa.getSize(); i++)
+  sdsl::select_support_mcl<1> plcp_select(&plcp_bits);
+
+  // Stream the ILCP array in suffix array order: the positions are located in parallel
+  // blocks, and the run heads are emitted directly into the encoder and the values.
+  usint threads = 1;
+#ifdef _OPENMP
+  threads = std::max(omp_get_max_threads(), 1);
+#endif
+  usint* positions = new usint[threads * BLOCK_SIZE];
+  uint* values = new uint[threads * BLOCK_SIZE];
+  std::vector<uint> heads_buffer;
+  CSA::DeltaVector::Encoder encoder(DV_BLOCK_SIZE);
+  for(usint i = 0; i < size; i += threads * BLOCK_SIZE)
   {
-    if(iLCP[i] != iLCP[i - 1]) { n_run_heads++; }
-  }
+    usint chunk_end = std::min(size, i + threads * BLOCK_SIZE);
+    #pragma omp parallel for schedule(static)
+    for(usint j = i; j < chunk_end; j += BLOCK_SIZE)
+    {
+      pair_type range(j, std::min(j + BLOCK_SIZE, chunk_end) - 1);
+      rlcsa.locate(range, positions + (j - i));
+      for(usint k = range.first; k <= range.second; k++)
+      {
+        usint pos = positions[k - i];
+        usint doc = std::upper_bound(starts.begin(), starts.end(), pos) - starts.begin() - 1;
+        usint gap_free = offsets[doc] + pos - starts[doc];
+        values[k - i] = plcp_select(gap_free + 1) - 2 * gap_free;
+      }
+    }
 
-  // Build RMQ for the run heads
-  sdsl::int_vector<32> heads(n_run_heads); heads[0] = iLCP[0];
-  CSA::DeltaVector::Encoder encoder(DV_BLOCK_SIZE); encoder.setBit(0);
-  for(usint i = 1, j = 1; i < this->rlcsa.getSize(); i++)
-  {
-    if(iLCP[i] != iLCP[i - 1])
+    for(usint k = i; k < chunk_end; k++)
     {
-      heads[j] = iLCP[i]; j++;
-      encoder.setBit(i);
+      if(k == 0 || values[k - i] != heads_buffer.back())
+      {
+        heads_buffer.push_back(values[k - i]);
+        encoder.setBit(k);
+      }
     }
   }
-  this->rmq = new RMQType(&heads);
-  this->run_heads = new CSA::DeltaVector(encoder, this->rlcsa.getSize());
+  delete[] positions; positions = 0;
+  delete[] values; values = 0;
+  plcp_select = sdsl::select_support_mcl<1>(); sdsl::util::clear(plcp_bits);
 
-  this->status = st_ok;
+  sdsl::int_vector<32> heads(heads_buffer.size());
+  for(usint j = 0; j < heads_buffer.size(); j++) { heads[j] = heads_buffer[j]; }
+
+  if(run_heads != 0) { *run_heads = new CSA::DeltaVector(encoder, size); }
+  return heads;
 }
 
 DoclistILCP::DoclistILCP(const RLCSA& _rlcsa, const std::string& base_name, bool load_docarray) :
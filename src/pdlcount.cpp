@@ -0,0 +1,125 @@
+#include <iostream>
+
+#include "drl/pdlcount.h"
+
+//--------------------------------------------------------------------------
+
+PDLCount::PDLCount(const RLCSA& _rlcsa, usint block_size, bool _fast_count, bool print) :
+  rlcsa(_rlcsa), fast_count(_fast_count), ok(false),
+  tree(0), counts(0)
+{
+  if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
+  {
+    std::cerr << "PDLCount::PDLCount(): Invalid RLCSA!" << std::endl;
+    return;
+  }
+
+  // All nodes are stored in these modes, so the storing parameter is not used.
+  this->tree = new PDLTree(this->rlcsa, block_size, 0,
+    (this->fast_count ? PDLTree::mode_fc : PDLTree::mode_count), print);
+  if(!(this->tree->isOk())) { return; }
+  this->counts = this->tree->getCounts();
+  this->tree->deleteNodes();
+  if(this->counts == 0) { return; }
+
+  this->ok = true;
+}
+
+PDLCount::PDLCount(const RLCSA& _rlcsa, const std::string& base_name, bool _fast_count) :
+  rlcsa(_rlcsa), fast_count(_fast_count), ok(false),
+  tree(0), counts(0)
+{
+  if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
+  {
+    std::cerr << "PDLCount::PDLCount(): Invalid RLCSA!" << std::endl;
+    return;
+  }
+
+  std::string input_name = this->getFileName(base_name);
+  std::ifstream input(input_name.c_str(), std::ios_base::binary);
+  if(!input)
+  {
+    std::cerr << "PDLCount::PDLCount(): Cannot open input file " << input_name << std::endl;
+    return;
+  }
+  this->tree = new PDLTree(this->rlcsa, input);
+  if(!(this->tree->isOk())) { return; }
+  this->counts = new CSA::Array(input);
+  input.close();
+
+  this->ok = true;
+}
+
+PDLCount::~PDLCount()
+{
+  delete this->tree; this->tree = 0;
+  delete this->counts; this->counts = 0;
+}
+
+void
+PDLCount::writeTo(const std::string& base_name) const
+{
+  if(!(this->isOk()))
+  {
+    std::cerr << "PDLCount::writeTo(): Status is not ok!" << std::endl;
+    return;
+  }
+
+  std::string filename = this->getFileName(base_name);
+  std::ofstream output(filename.c_str(), std::ios_base::binary);
+  if(!output)
+  {
+    std::cerr << "PDLCount::writeTo(): Cannot open output file " << filename << std::endl;
+    return;
+  }
+
+  this->tree->writeTo(output);
+  this->counts->writeTo(output);
+
+  output.close();
+}
+
+usint
+PDLCount::reportSize() const
+{
+  usint bytes = sizeof(*this);
+  if(this->tree != 0) { bytes += this->tree->reportSize(); }
+  if(this->counts != 0) { bytes += this->counts->reportSize(); }
+  return bytes;
+}
+
+std::string
+PDLCount::getFileName(const std::string& base_name) const
+{
+  return base_name + (this->fast_count ? PDLTree::FAST_COUNT_EXTENSION : PDLTree::COUNT_EXTENSION);
+}
+
+//--------------------------------------------------------------------------
+
+usint
+PDLCount::count(const std::string& pattern) const
+{
+  if(!(this->isOk())) { return 0; }
+  return this->count(this->rlcsa.count(pattern));
+}
+
+usint
+PDLCount::count(pair_type sa_range) const
+{
+  if(!(this->isOk()) || CSA::isEmpty(sa_range) || sa_range.second >= this->rlcsa.getSize()) { return 0; }
+
+  // The range corresponds to a node.
+  usint block = this->tree->getBlock(sa_range);
+  if(block < this->tree->getNumberOfNodes()) { return this->counts->getItem(block); }
+
+  // In PDL-fast, the pattern ranges inside a leaf have one occurrence per document.
+  if(this->fast_count && this->tree->getNextBlock(pair_type(sa_range.first, sa_range.first)).first > sa_range.second)
+  {
+    return CSA::length(sa_range);
+  }
+
+  // Partial blocks.
+  return bruteForceDocCount(this->rlcsa, sa_range);
+}
+
+//--------------------------------------------------------------------------
@@ -1,16 +1,17 @@
 #include <iostream>
-#include <stack>
 
 #include "drl/pdlrp.h"
+#include "drl/dedup.h"
 
 //--------------------------------------------------------------------------
 
 const std::string PDLRP::EXTENSION = ".pdlrp";
 const std::string PDLRP::SET_EXTENSION = ".pdlset";
 
-PDLRP::PDLRP(const RLCSA& _rlcsa, const std::string& base_name, bool compress_sets, bool use_rpset) :
+PDLRP::PDLRP(const RLCSA& _rlcsa, const std::string& base_name, bool compress_sets, bool use_rpset,
+             bool fast_tree, bool mapped, bool populate, usint rule_cache) :
   rlcsa(_rlcsa), status(st_error),
-  tree(0), grammar(0), blocks(0)
+  tree(0), grammar(0), blocks(0), cache(0)
 {
   if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
   {
@@ -28,7 +29,16 @@ PDLRP::PDLRP(const RLCSA& _rlcsa, const std::string& base_name, bool compress_se
     std::cerr << "PDLRP::PDLRP(): Cannot open input file " << input_name << std::endl;
     return;
   }
-  this->tree = new PDLTree(this->rlcsa, input);
+  if(mapped)
+  {
+    this->mapped_file = std::make_shared<drl::MappedFile>(input_name, populate);
+    if(!(this->mapped_file->isOk()))
+    {
+      std::cerr << "PDLRP::PDLRP(): Cannot map input file " << input_name << "; reading it instead" << std::endl;
+    }
+    else { this->mapped_file->adviseRandom(); } // Queries touch the sets at random; read-ahead only wastes I/O.
+  }
+  this->tree = new PDLTree(this->rlcsa, input, fast_tree, this->mapped_file);
   if(!(this->tree->isOk())) { return; }
   this->status = st_unfinished;
 
@@ -42,12 +52,13 @@ PDLRP::PDLRP(const RLCSA& _rlcsa, const std::string& base_name, bool compress_se
   {
     pair_type temp;
     input.read((char*)&temp, sizeof(temp)); // Items, bits.
-    this->grammar = new CSA::ReadBuffer(input, temp.first, temp.second);
+    this->grammar = drl::LoadReadBuffer(input, this->mapped_file, temp.first, temp.second);
     this->blocks = CSA::MultiArray::readFrom(input);
   }
   input.close();
   if(this->blocks == 0 || !(this->blocks->isOk())) { return; }
 
+  if(rule_cache > 0) { this->cache = new drl::RuleCache(rule_cache); }
   this->status = st_ok;
 }
 
@@ -56,6 +67,7 @@ PDLRP::~PDLRP()
   delete this->tree; this->tree = 0;
   delete this->grammar; this->grammar = 0;
   delete this->blocks; this->blocks = 0;
+  delete this->cache; this->cache = 0;
 }
 
 void
@@ -110,6 +122,26 @@ PDLRP::query(pair_type sa_range) const
   return this->queryUnsafe(sa_range);
 }
 
+bool
+PDLRP::query(const std::string& pattern, result_type& result) const
+{
+  result.clear();
+  if(!(this->isOk())) { return false; }
+  pair_type sa_range = this->rlcsa.count(pattern);
+  if(CSA::isEmpty(sa_range)) { return false; }
+  this->queryUnsafe(sa_range, result);
+  return true;
+}
+
+bool
+PDLRP::query(pair_type sa_range, result_type& result) const
+{
+  result.clear();
+  if(!(this->isOk()) || CSA::isEmpty(sa_range) || sa_range.second >= this->rlcsa.getSize()) { return false; }
+  this->queryUnsafe(sa_range, result);
+  return true;
+}
+
 usint
 PDLRP::count(const std::string& pattern) const
 {
@@ -122,26 +154,31 @@ PDLRP::count(pair_type sa_range) const
 {
   if(!(this->isOk()) || CSA::isEmpty(sa_range) || sa_range.second >= this->rlcsa.getSize()) { return 0; }
 
-  result_type* res = this->queryUnsafe(sa_range);
-  if(res == 0) { return 0; }
-  usint num = res->size();
-  delete res; res = 0;
+  thread_local result_type res;
+  res.clear();
+  this->queryUnsafe(sa_range, res);
 
-  return num;
+  return res.size();
 }
 
 PDLRP::result_type*
 PDLRP::queryUnsafe(pair_type sa_range) const
 {
   result_type* result = new result_type;
+  this->queryUnsafe(sa_range, *result);
+  return result;
+}
 
+void
+PDLRP::queryUnsafe(pair_type sa_range, result_type& result) const
+{
   // Process the part of the range before the first full block.
   pair_type first_block = this->tree->getFirstBlock(sa_range);
   if(first_block.first > sa_range.first)
   {
     usint temp = std::min(sa_range.second, first_block.first - 1);
-    bruteForceDocList(this->rlcsa, pair_type(sa_range.first, temp), result);
-    if(sa_range.second <= temp) { CSA::removeDuplicates(result, false); return result; }
+    bruteForceDocList(this->rlcsa, pair_type(sa_range.first, temp), &result);
+    if(sa_range.second <= temp) { drl::Dedup(result); return; }
   }
   usint current = first_block.second; // Current block.
 
@@ -149,13 +186,13 @@ PDLRP::queryUnsafe(pair_type sa_range) const
   pair_type last_block = this->tree->getLastBlock(sa_range);
   if(last_block.second == this->tree->getNumberOfNodes()) // No block ends before the end of the range.
   {
-    bruteForceDocList(this->rlcsa, pair_type(first_block.first, sa_range.second), result);
-    CSA::removeDuplicates(result, false);
-    return result;
+    bruteForceDocList(this->rlcsa, pair_type(first_block.first, sa_range.second), &result);
+    drl::Dedup(result);
+    return;
   }
   if(last_block.first < sa_range.second)
   {
-    bruteForceDocList(this->rlcsa, pair_type(last_block.first + 1, sa_range.second), result);
+    bruteForceDocList(this->rlcsa, pair_type(last_block.first + 1, sa_range.second), &result);
   }
   usint limit = last_block.second + 1;  // First block not in the range.
 
@@ -174,29 +211,27 @@ PDLRP::queryUnsafe(pair_type sa_range) const
     {
       if(run_length > 0)
       {
-        if(this->addBlocks(run_start, run_length, result)) { return result; }
+        if(this->addBlocks(run_start, run_length, &result)) { return; }
         run_length = 0;
       }
-      if(this->addBlocks(ancestor.first, 1, result)) { return result; }
+      if(this->addBlocks(ancestor.first, 1, &result)) { return; }
       current = ancestor.second;
     }
   }
   if(run_length > 0)
   {
-    if(this->addBlocks(run_start, run_length, result)) { return result; }
+    if(this->addBlocks(run_start, run_length, &result)) { return; }
     run_length = 0;
   }
 
-  CSA::removeDuplicates(result, false);
-  return result;
+  drl::Dedup(result);
 }
 
 void
 allDocuments(PDLRP::result_type* result, usint n)
 {
-  PDLRP::result_type buffer; buffer.reserve(n);
-  for(usint i = 0; i < n; i++) { buffer.push_back(i); }
-  result->swap(buffer);
+  result->resize(n);
+  for(usint i = 0; i < n; i++) { (*result)[i] = i; }
 }
 
 bool
@@ -205,13 +240,27 @@ PDLRP::addBlocks(usint first_block, usint number_of_blocks, result_type* result)
   CSA::MultiArray::Iterator* iter = this->blocks->getIterator();
   iter->goToItem(first_block, 0); iter->setEnd(first_block + number_of_blocks, 0);
 
-  std::stack<usint> buffer;
+  auto report = [result](uint doc) { result->push_back(doc); };
+
+  thread_local std::vector<usint> buffer;
+  buffer.clear();
   while(!(iter->atEnd()))
   {
-    buffer.push(iter->nextItem());
+    usint value = iter->nextItem();
+
+    // Look up the rules stored in the block in the cache, and cache their expansions on a miss.
+    usint rule = 0, start = result->size();
+    bool cached = (this->cache != 0 && !(this->tree->isTerminal(value)));
+    if(cached)
+    {
+      rule = this->tree->toRule(value);
+      if(this->cache->report(rule, report)) { continue; }
+    }
+
+    buffer.push_back(value);
     while(!(buffer.empty()))
     {
-      usint value = buffer.top(); buffer.pop();
+      value = buffer.back(); buffer.pop_back();
       if(this->tree->isTerminal(value))
       {
         if(value == this->tree->getNumberOfDocuments())
@@ -225,10 +274,12 @@ PDLRP::addBlocks(usint first_block, usint number_of_blocks, result_type* result)
       else
       {
         value = this->tree->toRule(value);
-        buffer.push(this->grammar->readItemConst(2 * value + 1));
-        buffer.push(this->grammar->readItemConst(2 * value));
+        buffer.push_back(this->grammar->readItemConst(2 * value + 1));
+        buffer.push_back(this->grammar->readItemConst(2 * value));
       }
     }
+
+    if(cached) { this->cache->insert(rule, result->begin() + start, result->end()); }
   }
 
   delete iter; iter = 0;
@@ -1,6 +1,10 @@
+#include <new>
 #include <stack>
 
+#include <omp.h>
+
 #include "drl/pdltree.h"
+#include "drl/scratch.h"
 
 //--------------------------------------------------------------------------
 
@@ -36,47 +40,43 @@ operator<<(std::ostream& stream, const PDLTreeNode& data)
 
 PDLTreeNode::PDLTreeNode(uint lcp, pair_type sa_range) :
   string_depth(lcp), range(sa_range),
-  parent(0), child(0), sibling(0), next(0),
-  stored_documents(0), id(0), contains_all(false),
+  parent(0), child(0), last_child(0), sibling(0), next(0),
+  stored_documents(0), id(0), contains_all(false), remove_this(false),
   docs(0)
 {
 }
 
 PDLTreeNode::~PDLTreeNode()
 {
-  this->parent = 0;
   delete this->docs; this->docs = 0;
-  delete this->child; this->child = 0;
-  while(this->sibling != 0)
-  {
-    PDLTreeNode* temp = this->sibling; this->sibling = this->sibling->sibling;
-    temp->sibling = 0; delete temp;
-  }
 }
 
 void
 PDLTreeNode::addChild(PDLTreeNode* node)
 {
   node->parent = this;
-  if(this->child == 0) { this->child = node; return; }
-  this->child->addSibling(node);
+  if(this->child == 0) { this->child = node; }
+  else                 { this->last_child->sibling = node; }
+  this->last_child = node;
 }
 
 void
-PDLTreeNode::addSibling(PDLTreeNode* node)
+PDLTreeNode::deleteChildren(PDLTreeNodeArena& arena)
 {
-  if(this->sibling == 0) { this->sibling = node; return; }
-  this->sibling->addSibling(node);
-}
+  std::stack<PDLTreeNode*> nodestack;
+  for(PDLTreeNode* curr = this->child; curr != 0; curr = curr->sibling) { nodestack.push(curr); }
+  this->child = this->last_child = 0;
 
-void
-PDLTreeNode::deleteChildren()
-{
-  delete this->child; this->child = 0;
+  while(!(nodestack.empty()))
+  {
+    PDLTreeNode* curr = nodestack.top(); nodestack.pop();
+    for(PDLTreeNode* temp = curr->child; temp != 0; temp = temp->sibling) { nodestack.push(temp); }
+    arena.release(curr);
+  }
 }
 
 void
-PDLTreeNode::addLeaves()
+PDLTreeNode::addLeaves(PDLTreeNodeArena& arena)
 {
   std::stack<PDLTreeNode*> nodestack;
   nodestack.push(this);
@@ -89,23 +89,24 @@ PDLTreeNode::addLeaves()
     PDLTreeNode* prev = 0;
     for(PDLTreeNode* temp = curr->child; temp != 0; temp = temp->sibling)
     {
-      while(expect < temp->range.first) { prev = curr->addLeaf(prev, temp, expect); expect++; }
+      while(expect < temp->range.first) { prev = curr->addLeaf(prev, temp, expect, arena); expect++; }
       nodestack.push(temp);
       expect = temp->range.second + 1;
       prev = temp;
     }
-    while(expect < curr->range.second + 1) { prev = curr->addLeaf(prev, 0, expect); expect++; }
+    while(expect < curr->range.second + 1) { prev = curr->addLeaf(prev, 0, expect, arena); expect++; }
   }
 }
 
 PDLTreeNode*
-PDLTreeNode::addLeaf(PDLTreeNode* left, PDLTreeNode* right, usint pos)
+PDLTreeNode::addLeaf(PDLTreeNode* left, PDLTreeNode* right, usint pos, PDLTreeNodeArena& arena)
 {
-  PDLTreeNode* leaf = new PDLTreeNode(0, pair_type(pos, pos));
+  PDLTreeNode* leaf = arena.create(0, pair_type(pos, pos));
   leaf->parent = this;
   if(left == 0) { this->child = leaf; }
   else          { left->sibling = leaf; }
   leaf->sibling = right;
+  if(right == 0) { this->last_child = leaf; }
   return leaf;
 }
 
@@ -158,10 +159,10 @@ PDLTreeNode::remove()
     for(curr = this->parent->child; curr->sibling != this; curr = curr->sibling);
     curr->sibling = this->child;
   }
-  for(curr = this->child; curr->sibling != 0; curr = curr->sibling);
-  curr->sibling = this->sibling;
+  this->last_child->sibling = this->sibling;
+  if(this == this->parent->last_child) { this->parent->last_child = this->last_child; }
 
-  this->parent = this->child = this->sibling = 0;
+  this->parent = this->child = this->last_child = this->sibling = 0;
 }
 
 void
@@ -203,7 +204,12 @@ PDLTreeNode::computeStoredDocuments(usint* documents)
   }
   else
   {
-    this->docs = new std::vector<Document>;
+    usint total = 0;
+    for(PDLTreeNode* curr = this->child; curr != 0; curr = curr->sibling)
+    {
+      if(curr->docs != 0) { total += curr->docs->size(); }
+    }
+    this->docs = new std::vector<Document>; this->docs->reserve(total);
     for(PDLTreeNode* curr = this->child; curr != 0; curr = curr->sibling)
     {
       if(curr->contains_all && curr->docs == 0) // Contains all docs; document set not stored.
@@ -283,11 +289,124 @@ PDLTreeNode::canDeleteChildren()
 
 //--------------------------------------------------------------------------
 
-PDLTree::PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_parameter, mode_type _mode, bool print) :
+PDLTreeNodeArena::PDLTreeNodeArena() :
+  nodes(0), free_list(0), released(0)
+{
+}
+
+PDLTreeNodeArena::~PDLTreeNodeArena()
+{
+  this->clear();
+}
+
+PDLTreeNode*
+PDLTreeNodeArena::create(uint lcp, pair_type sa_range)
+{
+  if(this->free_list != 0)
+  {
+    PDLTreeNode* node = this->free_list;
+    this->free_list = node->next; this->released--;
+    node->~PDLTreeNode();
+    return new(node) PDLTreeNode(lcp, sa_range);
+  }
+
+  usint offset = this->nodes % BLOCK_SIZE;
+  if(offset == 0)
+  {
+    this->blocks.push_back(static_cast<PDLTreeNode*>(::operator new(BLOCK_SIZE * sizeof(PDLTreeNode))));
+  }
+  this->nodes++;
+  return new(this->blocks.back() + offset) PDLTreeNode(lcp, sa_range);
+}
+
+void
+PDLTreeNodeArena::release(PDLTreeNode* node)
+{
+  delete node->docs; node->docs = 0;
+  node->next = this->free_list; this->free_list = node;
+  this->released++;
+}
+
+void
+PDLTreeNodeArena::clear()
+{
+  for(usint i = 0; i < this->blocks.size(); i++)
+  {
+    usint block_nodes = std::min(this->nodes - i * BLOCK_SIZE, (usint)BLOCK_SIZE);
+    for(usint j = 0; j < block_nodes; j++) { this->blocks[i][j].~PDLTreeNode(); }
+    ::operator delete(this->blocks[i]);
+  }
+  this->blocks.clear();
+  this->nodes = 0; this->free_list = 0; this->released = 0;
+}
+
+//--------------------------------------------------------------------------
+
+void
+PDLTree::buildSet(PDLTreeNode* curr, usint* documents, uint docs, uint& leaves, uint& nodes)
+{
+  // Replace the removed children with their children. They have already been processed.
+  for(PDLTreeNode* child = curr->child; child != 0; )
+  {
+    PDLTreeNode* next = child->sibling;
+    if(child->remove_this)
+    {
+      child->remove();
+      #pragma omp critical(pdltree_node_arena)
+      this->nodes->release(child);
+    }
+    child = next;
+  }
+
+  curr->computeStoredDocuments(documents);
+  if(curr->docs != 0 && curr->docs->size() >= docs) { curr->containsAllDocuments(this->useContainsAll()); }
+  if(this->mode == mode_fc) // FIXME should not have raw mode checks
+  {
+    // temp > 0 means that all children of curr are leaves with occ == docc.
+    usint temp = curr->canDeleteChildren();
+    if(temp > 0)
+    {
+      #pragma omp critical(pdltree_node_arena)
+      curr->deleteChildren(*(this->nodes));
+      leaves -= temp;
+    }
+  }
+
+  if(this->storeAllInternalNodes() ||
+     curr->child == 0 || curr->contains_all || curr->stored_documents > storing_parameter * curr->docs->size())
+  {
+    curr->storeThisSet(this->canRemoveSets());
+    if(curr->child == 0) { leaves++; }
+    else                 { nodes++; }
+  }
+  else
+  {
+    curr->remove_this = true;  // The parent removes the node.
+  }
+}
+
+//--------------------------------------------------------------------------
+
+namespace
+{
+
+// Print the time since phase_start and restart the timer.
+void
+printPhaseTime(const std::string& phase, double& phase_start)
+{
+  double now = CSA::readTimer();
+  std::cout << "  " << phase << ": " << (now - phase_start) << " seconds" << std::endl;
+  phase_start = now;
+}
+
+}
+
+PDLTree::PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_parameter, mode_type _mode, bool print,
+                 usint memory_budget, const std::string& temp_dir) :
   rlcsa(_rlcsa), block_size(_block_size), storing_parameter(_storing_parameter),
   ok(false), mode(_mode), sort_order(sort_none),
-  leaf_ranges(0), first_children(0), parents(0), next_leaves(0),
-  root(0)
+  leaf_ranges(0), first_children(0), parents(0), next_leaves(0), fast(false),
+  nodes(0), root(0)
 {
   if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
   {
@@ -301,39 +420,56 @@ PDLTree::PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_paramete
     return;
   }
 
-  // Build SA.
-  if(print) { std::cout << "Building SA..." << std::endl; }
+  // The SA/DA and LCP arrays are only accessed with sequential passes, so they can be
+  // mapped to scratch files if they do not fit in the memory budget.
   usint size = this->rlcsa.getSize();
   uint docs = this->rlcsa.getNumberOfSequences();
-  usint* documents = new usint[size];
+  bool mapped = (memory_budget > 0 && size * (sizeof(usint) + sizeof(uint)) > memory_budget);
+  if(print && mapped) { std::cout << "Using scratch files in " << temp_dir << "..." << std::endl; }
+  double start = CSA::readTimer(), phase_start = start;
+
+  // Build SA.
+  if(print) { std::cout << "Building SA..." << std::endl; }
+  drl::ScratchArray<usint> documents(size, mapped, temp_dir);
+  documents.adviseSequential();
   #pragma omp parallel for schedule(static)
   for(usint i = 0; i < size; i += CSA::MEGABYTE)
   {
-    this->rlcsa.locate(pair_type(i, std::min(i + CSA::MEGABYTE - 1, size - 1)), documents + i);
+    this->rlcsa.locate(pair_type(i, std::min(i + CSA::MEGABYTE - 1, size - 1)), documents.data() + i);
   }
+  if(print) { printPhaseTime("SA", phase_start); }
 
   // Build LCP.
   if(print) { std::cout << "Building LCP..." << std::endl; }
-  uint* lcp = new uint[size + 1]; lcp[size] = 0;
+  drl::ScratchArray<uint> lcp(size + 1, mapped, temp_dir); lcp[size] = 0;
+  lcp.adviseSequential();
   CSA::PLCPVector* plcpvec = this->rlcsa.buildPLCP(16);
-  CSA::PLCPVector::Iterator iter(*plcpvec);
-  for(usint i = 0; i < size; i++)
+  if(print) { printPhaseTime("PLCP", phase_start); }
+  #pragma omp parallel for schedule(static)
+  for(usint i = 0; i < size; i += CSA::MEGABYTE)
   {
-    lcp[i] = iter.select(documents[i]) - 2 * documents[i];
+    CSA::PLCPVector::Iterator iter(*plcpvec);  // Iterators are not thread-safe.
+    usint limit = std::min(i + CSA::MEGABYTE, size);
+    for(usint j = i; j < limit; j++) { lcp[j] = iter.select(documents[j]) - 2 * documents[j]; }
   }
   delete plcpvec; plcpvec = 0;
+  lcp.release();
+  if(print) { printPhaseTime("LCP", phase_start); }
 
   // Convert SA to DA.
   if(print) { std::cout << "Building DA..." << std::endl; }
   #pragma omp parallel for schedule(static)
   for(usint i = 0; i < size; i += CSA::MEGABYTE)
   {
-    this->rlcsa.getSequenceForPosition(documents + i, std::min(CSA::MEGABYTE, size - i));
+    this->rlcsa.getSequenceForPosition(documents.data() + i, std::min(CSA::MEGABYTE, size - i));
   }
+  documents.release();
+  if(print) { printPhaseTime("DA", phase_start); }
 
   // Build ST. Kind of.
   if(print) { std::cout << "Building ST..." << std::endl; }
-  std::stack<PDLTreeNode*> nodestack; nodestack.push(new PDLTreeNode(0, pair_type(0, 0)));
+  this->nodes = new PDLTreeNodeArena;
+  std::stack<PDLTreeNode*> nodestack; nodestack.push(this->nodes->create(0, pair_type(0, 0)));
   PDLTreeNode* prev = 0;
   for(usint i = 1; i <= size; i++)
   {
@@ -342,65 +478,66 @@ PDLTree::PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_paramete
     {
       nodestack.top()->range.second = i - 1;
       prev = nodestack.top(); nodestack.pop();
-      if(CSA::length(prev->range) <= this->block_size) { prev->deleteChildren(); }
+      if(CSA::length(prev->range) <= this->block_size) { prev->deleteChildren(*(this->nodes)); }
       this->root = prev;  // Last processed node.
       left = prev->range.first;
       if(lcp[i] <= nodestack.top()->string_depth) { nodestack.top()->addChild(prev); prev = 0; }
     }
     if(lcp[i] > nodestack.top()->string_depth)
     {
-      PDLTreeNode* curr = new PDLTreeNode(lcp[i], pair_type(left, left));
+      PDLTreeNode* curr = this->nodes->create(lcp[i], pair_type(left, left));
       if(prev != 0) { curr->addChild(prev); prev = 0; }
       nodestack.push(curr);
     }
   }
   while(this->root->parent != 0) { this->root = this->root->parent; }  // Find the actual root.
   root->range.second = size - 1; // root->containsAllDocuments(this->contains_all);
-  delete[] lcp; lcp = 0;
-  root->addLeaves();
+  lcp.clear();
+  root->addLeaves(*(this->nodes));
   root->verifyTree();
+  if(print) { printPhaseTime("ST", phase_start); }
 
-  // Build the sets of document ids.
+  // Build the sets of document ids. The nodes are processed in parallel by height, as
+  // the children of a node have smaller heights. The height is stored in the id field,
+  // which is set later. Levels with fewer nodes than threads (near the root, where the
+  // sets are largest) are processed outside the parallel region, so that the sorts in
+  // mergeDuplicates() can use all threads.
   if(print) { std::cout << "Building sets..." << std::endl; }
-  uint tree_leaves = 0, tree_nodes = 0;
+  std::vector<PDLTreeNode*> order;
+  std::vector<usint> level_start(1, 0);
   while(!nodestack.empty()) { nodestack.pop(); }
   for(prev = this->root; prev != 0; prev = prev->child) { nodestack.push(prev); }
   while(!(nodestack.empty()))
   {
     PDLTreeNode* curr = nodestack.top(); nodestack.pop();
     for(PDLTreeNode* temp = curr->sibling; temp != 0; temp = temp->child) { nodestack.push(temp); }
+    curr->id = 0;
+    for(PDLTreeNode* temp = curr->child; temp != 0; temp = temp->sibling) { curr->id = std::max(curr->id, temp->id + 1); }
+    if(curr->id + 1 >= level_start.size()) { level_start.resize(curr->id + 2, 0); }
+    level_start[curr->id + 1]++;
+    order.push_back(curr);
+  }
+  for(usint h = 1; h < level_start.size(); h++) { level_start[h] += level_start[h - 1]; }
+  {
+    std::vector<usint> level_end(level_start.begin(), level_start.end() - 1);
+    std::vector<PDLTreeNode*> postorder; postorder.swap(order); order.resize(postorder.size());
+    for(usint i = 0; i < postorder.size(); i++) { order[level_end[postorder[i]->id]++] = postorder[i]; }
+  }
 
-    curr->computeStoredDocuments(documents);
-    if(curr->docs != 0 && curr->docs->size() >= docs) { curr->containsAllDocuments(this->useContainsAll()); }
-    if(this->mode == mode_fc) // FIXME should not have raw mode checks
-    {
-      // temp > 0 means that all children of curr are leaves with occ == docc.
-      usint temp = curr->canDeleteChildren();
-      if(temp > 0) { curr->deleteChildren(); tree_leaves -= temp; }
-    }
-
-    if(this->storeAllInternalNodes())
-    {
-      curr->storeThisSet(this->canRemoveSets());
-      if(curr->child == 0) { tree_leaves++; }
-      else                 { tree_nodes++; }
-    }
-    else
+  uint tree_leaves = 0, tree_nodes = 0;
+  usint threads = std::max(omp_get_max_threads(), 1);
+  for(usint h = 0; h + 1 < level_start.size(); h++)
+  {
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:tree_leaves, tree_nodes) if(level_start[h + 1] - level_start[h] >= threads && threads > 1)
+    for(usint i = level_start[h]; i < level_start[h + 1]; i++)
     {
-      if(curr->child == 0 || curr->contains_all || curr->stored_documents > storing_parameter * curr->docs->size())
-      {
-        curr->storeThisSet(this->canRemoveSets());
-        if(curr->child == 0) { tree_leaves++; }
-        else                 { tree_nodes++; }
-      }
-      else
-      {
-        curr->remove();
-        delete curr; curr = 0;
-      }
+      this->buildSet(order[i], documents.data(), docs, tree_leaves, tree_nodes);
     }
   }
+  if(this->root->remove_this) { delete this->root->docs; this->root->docs = 0; }
+  order.clear(); level_start.clear();
   root->setNext();
+  if(print) { printPhaseTime("Sets", phase_start); }
 
   // Set node identifiers.
   if(print)
@@ -417,6 +554,7 @@ PDLTree::PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_paramete
     if(curr->child == 0) { curr->id = tree_leaves; tree_leaves++; }
     else                 { curr->id = tree_nodes; tree_nodes++; }
   }
+  if(print) { printPhaseTime("Identifiers", phase_start); }
 
   // Determine the SA ranges corresponding to the leaves and mark the first children.
   if(print) { std::cout << "Building tree..." << std::endl; }
@@ -457,30 +595,37 @@ PDLTree::PDLTree(const RLCSA& _rlcsa, usint _block_size, usint _storing_paramete
   }
   this->parents = par_buffer.getReadBuffer();
   this->next_leaves = next_buffer.getReadBuffer();
+  if(print)
+  {
+    printPhaseTime("Tree", phase_start);
+    std::cout << "PDLTree built in " << (CSA::readTimer() - start) << " seconds" << std::endl;
+  }
 
   this->ok = true;
 }
 
-PDLTree::PDLTree(const RLCSA& _rlcsa, std::ifstream& input) :
+PDLTree::PDLTree(const RLCSA& _rlcsa, std::ifstream& input, bool fast_layout,
+                 const std::shared_ptr<drl::MappedFile>& _mapped_file) :
   rlcsa(_rlcsa), block_size(0), storing_parameter(0),
   ok(false), mode(mode_rp), sort_order(sort_none),
-  leaf_ranges(0), first_children(0), parents(0), next_leaves(0),
-  root(0)
+  leaf_ranges(0), first_children(0), parents(0), next_leaves(0), mapped_file(_mapped_file), fast(false),
+  nodes(0), root(0)
 {
   this->leaf_ranges = new CSA::DeltaVector(input);
   this->first_children = new CSA::SuccinctVector(input);
-  this->parents = new CSA::ReadBuffer(input, this->getNumberOfInternalNodes(),
+  this->parents = drl::LoadReadBuffer(input, this->mapped_file, this->getNumberOfInternalNodes(),
     CSA::length(this->getNumberOfInternalNodes() - 1));
-  this->next_leaves = new CSA::ReadBuffer(input, this->getNumberOfInternalNodes(),
+  this->next_leaves = drl::LoadReadBuffer(input, this->mapped_file, this->getNumberOfInternalNodes(),
     CSA::length(this->getNumberOfLeaves()));
   this->ok = true;
+  if(fast_layout) { this->buildFastLayout(); }
 }
 
-PDLTree::PDLTree(const RLCSA& _rlcsa, FILE* input) :
+PDLTree::PDLTree(const RLCSA& _rlcsa, FILE* input, bool fast_layout) :
   rlcsa(_rlcsa), block_size(0), storing_parameter(0),
   ok(false), mode(mode_rp), sort_order(sort_none),
-  leaf_ranges(0), first_children(0), parents(0), next_leaves(0),
-  root(0)
+  leaf_ranges(0), first_children(0), parents(0), next_leaves(0), fast(false),
+  nodes(0), root(0)
 {
   this->leaf_ranges = new CSA::DeltaVector(input);
   this->first_children = new CSA::SuccinctVector(input);
@@ -489,6 +634,7 @@ PDLTree::PDLTree(const RLCSA& _rlcsa, FILE* input) :
   this->next_leaves = new CSA::ReadBuffer(input, this->getNumberOfInternalNodes(),
     CSA::length(this->getNumberOfLeaves()));
   this->ok = true;
+  if(fast_layout) { this->buildFastLayout(); }
 }
 
 PDLTree::~PDLTree()
@@ -497,7 +643,7 @@ PDLTree::~PDLTree()
   delete this->first_children; this->first_children = 0;
   delete this->parents; this->parents = 0;
   delete this->next_leaves; this->next_leaves = 0;
-  delete this->root; this->root = 0;
+  delete this->nodes; this->nodes = 0; this->root = 0;
 }
 
 void
@@ -534,6 +680,11 @@ PDLTree::reportSize() const
   if(this->first_children != 0) { bytes += this->first_children->reportSize(); }
   if(this->parents != 0) { bytes += this->parents->reportSize(); }
   if(this->next_leaves != 0) { bytes += this->next_leaves->reportSize(); }
+  bytes += this->leaf_starts.capacity() * sizeof(usint);
+  bytes += this->leaf_tree.capacity() * sizeof(usint);
+  bytes += this->leaf_tree_ranks.capacity() * sizeof(uint);
+  bytes += this->node_parents.capacity() * sizeof(uint);
+  bytes += this->internal_next_leaves.capacity() * sizeof(uint);
   return bytes;
 }
 
@@ -624,25 +775,95 @@ PDLTree::getCounts()
 void
 PDLTree::deleteNodes()
 {
-  delete this->root; this->root = 0;
+  delete this->nodes; this->nodes = 0; this->root = 0;
+}
+
+namespace
+{
+
+// Fills the subtree rooted at k of the Eytzinger layout with the next values in sorted order.
+void
+fillEytzinger(const std::vector<usint>& sorted, usint& next, usint k, std::vector<usint>& tree, std::vector<uint>& ranks)
+{
+  if(k >= tree.size()) { return; }
+  fillEytzinger(sorted, next, 2 * k, tree, ranks);
+  tree[k] = sorted[next]; ranks[k] = next; next++;
+  fillEytzinger(sorted, next, 2 * k + 1, tree, ranks);
+}
+
+}
+
+void
+PDLTree::buildFastLayout()
+{
+  if(!(this->isOk()) || this->fast) { return; }
+
+  usint leaves = this->getNumberOfLeaves(), internal = this->getNumberOfInternalNodes();
+  this->leaf_starts.resize(leaves + 1);
+  CSA::DeltaVector::Iterator leaf_iter(*(this->leaf_ranges));
+  for(pair_type curr = leaf_iter.valueAfter(0); curr.second < leaves; curr = leaf_iter.nextValue())
+  {
+    this->leaf_starts[curr.second] = curr.first;
+  }
+  this->leaf_starts[leaves] = this->leaf_ranges->getSize();
+
+  this->leaf_tree.resize(leaves + 1); this->leaf_tree_ranks.resize(leaves + 1);
+  usint next = 0;
+  fillEytzinger(this->leaf_starts, next, 1, this->leaf_tree, this->leaf_tree_ranks);
+
+  uint no_parent = NO_PARENT;
+  this->node_parents.assign(this->getNumberOfNodes(), no_parent);
+  CSA::SuccinctVector::Iterator child_iter(*(this->first_children));
+  for(pair_type curr = child_iter.valueAfter(0); curr.second < internal; curr = child_iter.nextValue())
+  {
+    this->node_parents[curr.first] = this->parents->readItemConst(curr.second);
+  }
+
+  this->internal_next_leaves.resize(internal);
+  for(usint i = 0; i < internal; i++) { this->internal_next_leaves[i] = this->next_leaves->readItemConst(i); }
+
+  this->fast = true;
 }
 
 //--------------------------------------------------------------------------
 
 usint
-PDLTree::getBlock(pair_type sa_range) const
+PDLTree::leavesBefore(usint pos) const
 {
-  // Check whether range.first starts a new block.
-  CSA::DeltaVector::Iterator block_iter(*(this->leaf_ranges));
-  pair_type first_block = this->getFirstBlock(sa_range, block_iter);
-  if(first_block.first > sa_range.first)
+  // Lower bound in the Eytzinger layout: descend to a null node and backtrack to the
+  // last node where the search went left.
+  usint k = 1, n = this->leaf_tree.size();
+  while(k < n) { k = 2 * k + (this->leaf_tree[k] < pos); }
+  k >>= __builtin_ffsll(~k);
+  return (k == 0 ? n - 1 : this->leaf_tree_ranks[k]);
+}
+
+bool
+PDLTree::getBlockBoundaries(pair_type sa_range, pair_type& first_block, pair_type& next_block) const
+{
+  if(this->fast)
   {
-    return this->getNumberOfNodes();
+    first_block = this->getFirstBlock(sa_range);
+    if(first_block.first > sa_range.first) { return false; }
+    next_block = this->getNextBlock(sa_range);
+    return (next_block.first == sa_range.second + 1);
   }
 
+  // Check whether range.first starts a new block.
+  CSA::DeltaVector::Iterator block_iter(*(this->leaf_ranges));
+  first_block = this->getFirstBlock(sa_range, block_iter);
+  if(first_block.first > sa_range.first) { return false; }
+
   // Check whether range.second ends a full block.
-  pair_type next_block = this->getNextBlock(sa_range, block_iter);
-  if(next_block.first != sa_range.second + 1)
+  next_block = this->getNextBlock(sa_range, block_iter);
+  return (next_block.first == sa_range.second + 1);
+}
+
+usint
+PDLTree::getBlock(pair_type sa_range) const
+{
+  pair_type first_block, next_block;
+  if(!(this->getBlockBoundaries(sa_range, first_block, next_block)))
   {
     return this->getNumberOfNodes();
   }
@@ -657,14 +878,8 @@ PDLTree::getBlocks(pair_type sa_range, std::vector<usint>& result) const
 {
   result.empty();
 
-  // Check whether range.first starts a new block.
-  CSA::DeltaVector::Iterator block_iter(*(this->leaf_ranges));
-  pair_type first_block = this->getFirstBlock(sa_range, block_iter);
-  if(first_block.first > sa_range.first) { return; }
-
-  // Check whether range.second ends a full block.
-  pair_type next_block = this->getNextBlock(sa_range, block_iter);
-  if(next_block.first != sa_range.second + 1) { return; }
+  pair_type first_block, next_block;
+  if(!(this->getBlockBoundaries(sa_range, first_block, next_block))) { return; }
 
   usint current = first_block.second;
   while(current < next_block.second)
@@ -678,6 +893,11 @@ PDLTree::getBlocks(pair_type sa_range, std::vector<usint>& result) const
 pair_type
 PDLTree::getFirstBlock(pair_type sa_range) const
 {
+  if(this->fast)
+  {
+    usint leaf = this->leavesBefore(sa_range.first);
+    return pair_type(this->leaf_starts[leaf], leaf);
+  }
   CSA::DeltaVector::Iterator iter(*(this->leaf_ranges));
   return this->getFirstBlock(sa_range, iter);
 }
@@ -691,10 +911,25 @@ PDLTree::getFirstBlock(pair_type sa_range, CSA::DeltaVector::Iterator& iter) con
 pair_type
 PDLTree::getLastBlock(pair_type sa_range) const
 {
-  CSA::DeltaVector::Iterator iter(*(this->leaf_ranges));
-  pair_type last_block = iter.valueBefore(sa_range.second);
-  pair_type next_block = iter.nextValue();
+  pair_type last_block, next_block;
+  if(this->fast)
+  {
+    usint leaf = this->leavesBefore(sa_range.second + 1);
+    last_block = pair_type(this->leaf_starts[leaf - 1], leaf - 1);
+    next_block = pair_type(this->leaf_starts[leaf], leaf);
+  }
+  else
+  {
+    CSA::DeltaVector::Iterator iter(*(this->leaf_ranges));
+    last_block = iter.valueBefore(sa_range.second);
+    next_block = iter.nextValue();
+  }
+  return this->lastBlock(sa_range, last_block, next_block);
+}
 
+pair_type
+PDLTree::lastBlock(pair_type sa_range, pair_type last_block, pair_type next_block) const
+{
   // Easy case: The range ends with a full block.
   if(next_block.first == sa_range.second + 1) { return pair_type(sa_range.second, last_block.second); }
 
@@ -705,9 +940,69 @@ PDLTree::getLastBlock(pair_type sa_range) const
   return pair_type(last_block.first - 1, last_block.second - 1);
 }
 
+namespace
+{
+
+// Per-thread buffer for the sorted range boundaries of getFirstAndLastBlocks().
+std::vector<pair_type>&
+boundaryBuffer()
+{
+  static thread_local std::vector<pair_type> boundaries;
+  return boundaries;
+}
+
+}
+
+void
+PDLTree::getFirstAndLastBlocks(const std::vector<pair_type>& sa_ranges,
+  std::vector<pair_type>& first_blocks, std::vector<pair_type>& last_blocks) const
+{
+  first_blocks.resize(sa_ranges.size()); last_blocks.resize(sa_ranges.size());
+  if(sa_ranges.empty()) { return; }
+
+  // Boundary (pos, 2 * i) is the start of range i and (pos, 2 * i + 1) follows its end.
+  std::vector<pair_type>& boundaries = boundaryBuffer();
+  boundaries.clear(); boundaries.reserve(2 * sa_ranges.size());
+  for(usint i = 0; i < sa_ranges.size(); i++)
+  {
+    boundaries.push_back(pair_type(sa_ranges[i].first, 2 * i));
+    boundaries.push_back(pair_type(sa_ranges[i].second + 1, 2 * i + 1));
+  }
+  CSA::sequentialSort(boundaries.begin(), boundaries.end());
+
+  // For each boundary, find the first leaf starting at or after it and the leaf before that.
+  // Nearby boundaries are reached by stepping the iterator, the others with a new search.
+  CSA::DeltaVector::Iterator iter(*(this->leaf_ranges));
+  pair_type curr = (this->fast ? pair_type(this->leaf_starts[0], 0) : iter.valueAfter(0)), prev = curr;
+  for(usint i = 0; i < boundaries.size(); i++)
+  {
+    usint pos = boundaries[i].first;
+    if(this->fast)
+    {
+      usint leaf = this->leavesBefore(pos);
+      curr = pair_type(this->leaf_starts[leaf], leaf);
+      if(leaf > 0) { prev = pair_type(this->leaf_starts[leaf - 1], leaf - 1); }
+    }
+    else
+    {
+      for(usint steps = 0; curr.first < pos && steps < SWEEP_STEPS; steps++) { prev = curr; curr = iter.nextValue(); }
+      if(curr.first < pos) { prev = iter.valueBefore(pos - 1); curr = iter.nextValue(); }
+    }
+
+    usint range = boundaries[i].second / 2;
+    if(boundaries[i].second % 2 == 0) { first_blocks[range] = curr; }
+    else { last_blocks[range] = this->lastBlock(sa_ranges[range], prev, curr); }
+  }
+}
+
 pair_type
 PDLTree::getNextBlock(pair_type sa_range) const
 {
+  if(this->fast)
+  {
+    usint leaf = this->leavesBefore(sa_range.second + 1);
+    return pair_type(this->leaf_starts[leaf], leaf);
+  }
   CSA::DeltaVector::Iterator iter(*(this->leaf_ranges));
   return this->getNextBlock(sa_range, iter);
 }
@@ -722,6 +1017,20 @@ PDLTree::getNextBlock(pair_type sa_range, CSA::DeltaVector::Iterator& iter) cons
 pair_type
 PDLTree::getAncestor(usint block, usint next_leaf) const
 {
+  if(this->fast)
+  {
+    pair_type current(block, block + 1);
+    while(current.second < next_leaf)
+    {
+      uint par = this->node_parents[current.first];
+      if(par == NO_PARENT) { break; } // Not a first child.
+      pair_type candidate(par + this->getNumberOfLeaves(), this->internal_next_leaves[par]);
+      if(candidate.second > next_leaf) { break; } // The candidate is too high.
+      current = candidate;
+    }
+    return current;
+  }
+
   CSA::SuccinctVector::Iterator iter(*(this->first_children));
 
   pair_type current(block, block + 1);
@@ -25,8 +25,14 @@
 
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "drl/utils.h"
+#include "drl/dedup.h"
 
 //--------------------------------------------------------------------------
 
@@ -126,6 +132,17 @@ sortByFrequency(std::vector<Document>* docs)
   CSA::sequentialSort(docs->begin(), docs->end(), mf_comparator);
 }
 
+void
+selectMostFrequent(std::vector<Document>* docs, usint k)
+{
+  if(docs->size() > k)
+  {
+    std::nth_element(docs->begin(), docs->begin() + k, docs->end(), mf_comparator);
+    docs->resize(k);
+  }
+  sortByFrequency(docs);
+}
+
 void
 mergeDocumentRuns(std::vector<Document>* docs)
 {
@@ -200,31 +217,242 @@ filterByMask(std::vector<ScoredDoc>& docs, ScoredDoc::mask_type mask)
 
 //--------------------------------------------------------------------------
 
+namespace
+{
+
+// The brute force algorithms process the range in chunks of this many positions.
+const usint BRUTE_FORCE_CHUNK = CSA::MILLION;
+
+// Top-k uses a dense histogram if the documents are at most this many times the range.
+const usint TOPK_DENSE_FACTOR = 16;
+
+// Maximum size in bytes of the per-thread dense histograms of a multi-chunk top-k.
+const usint TOPK_DENSE_BUDGET = 256 * CSA::MEGABYTE;
+
+// Writes the documents for positions [offset, offset + len) of the SA into the buffer.
+void
+bruteForceDocs(const RLCSA* rlcsa, const CSA::ReadBuffer* docarray, usint offset, usint len, usint* buffer)
+{
+  if(docarray == 0)
+  {
+    rlcsa->locate(pair_type(offset, offset + len - 1), buffer);
+    rlcsa->getSequenceForPosition(buffer, len);
+  }
+  else
+  {
+    for(usint i = 0; i < len; i++) { buffer[i] = docarray->readItemConst(offset + i); }
+  }
+}
+
+// Upper bound for the document identifiers.
+usint
+bruteForceDocBound(const RLCSA* rlcsa, const CSA::ReadBuffer* docarray)
+{
+  if(docarray == 0) { return rlcsa->getNumberOfSequences(); }
+  return ((usint)1) << docarray->getItemSize();
+}
+
+usint
+bruteForceChunks(pair_type sa_range)
+{
+  return (CSA::length(sa_range) + BRUTE_FORCE_CHUNK - 1) / BRUTE_FORCE_CHUNK;
+}
+
+usint
+bruteForceThreads(pair_type sa_range)
+{
+  usint threads = 1;
+#ifdef _OPENMP
+  threads = std::max(omp_get_max_threads(), 1);
+#endif
+  return std::min(threads, bruteForceChunks(sa_range));
+}
+
+// Processes the range in chunks, locating each chunk once. The chunks are distributed
+// among the threads, and process(thread, buffer, len) is called for each chunk with the
+// documents in a per-thread buffer. Memory usage is bounded by the chunk size.
+template<class Process>
+void
+bruteForceEngine(const RLCSA* rlcsa, const CSA::ReadBuffer* docarray, pair_type sa_range, usint threads, Process& process)
+{
+  usint chunks = bruteForceChunks(sa_range);
+  #pragma omp parallel num_threads(threads)
+  {
+    usint thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    usint* buffer = new usint[std::min(BRUTE_FORCE_CHUNK, CSA::length(sa_range))];
+    #pragma omp for schedule(dynamic, 1)
+    for(usint chunk = 0; chunk < chunks; chunk++)
+    {
+      usint offset = sa_range.first + chunk * BRUTE_FORCE_CHUNK;
+      usint len = std::min(BRUTE_FORCE_CHUNK, sa_range.second + 1 - offset);
+      bruteForceDocs(rlcsa, docarray, offset, len, buffer);
+      process(thread, buffer, len);
+    }
+    delete[] buffer; buffer = 0;
+  }
+}
+
+// Per-thread bitmaps of the documents found in a large range.
+class DocBitmaps
+{
+  public:
+    DocBitmaps(usint _threads, usint docs) :
+      threads(_threads), words(BITS_TO_WORDS(docs)), bits(_threads * BITS_TO_WORDS(docs), 0)
+    {
+    }
+
+    inline void operator()(usint thread, const usint* buffer, usint len)
+    {
+      usint* row = this->bits.data() + thread * this->words;
+      for(usint i = 0; i < len; i++) { row[buffer[i] / CSA::WORD_BITS] |= ((usint)1) << (buffer[i] % CSA::WORD_BITS); }
+    }
+
+    // Merges the bitmaps into the first one.
+    void merge()
+    {
+      for(usint t = 1; t < this->threads; t++)
+      {
+        const usint* row = this->bits.data() + t * this->words;
+        for(usint i = 0; i < this->words; i++) { this->bits[i] |= row[i]; }
+      }
+    }
+
+    usint count() const
+    {
+      usint docc = 0;
+      for(usint i = 0; i < this->words; i++) { docc += __builtin_popcountll(this->bits[i]); }
+      return docc;
+    }
+
+    // Appends the documents in increasing order.
+    void extract(std::vector<uint>* result) const
+    {
+      for(usint i = 0; i < this->words; i++)
+      {
+        for(usint word = this->bits[i]; word != 0; word &= word - 1)
+        {
+          result->push_back(i * CSA::WORD_BITS + __builtin_ctzll(word));
+        }
+      }
+    }
+
+  private:
+    usint              threads, words;
+    std::vector<usint> bits;
+};
+
+// Per-thread document frequencies in a large range.
+class DocFrequencies
+{
+  public:
+    DocFrequencies(usint _threads, usint _docs) :
+      threads(_threads), docs(_docs), freqs(_threads * _docs, 0)
+    {
+    }
+
+    inline void operator()(usint thread, const usint* buffer, usint len)
+    {
+      uint* row = this->freqs.data() + thread * this->docs;
+      for(usint i = 0; i < len; i++) { row[buffer[i]]++; }
+    }
+
+    // Merges the frequencies in parallel and appends the documents in increasing order of id.
+    void extract(std::vector<Document>* result)
+    {
+      uint* freqs = this->freqs.data();
+      #pragma omp parallel for schedule(static) num_threads(this->threads)
+      for(usint i = 0; i < this->docs; i++)
+      {
+        for(usint t = 1; t < this->threads; t++) { freqs[i] += freqs[t * this->docs + i]; }
+      }
+      for(usint i = 0; i < this->docs; i++)
+      {
+        if(this->freqs[i] > 0) { result->push_back(Document(i, this->freqs[i])); }
+      }
+    }
+
+  private:
+    usint             threads, docs;
+    std::vector<uint> freqs;
+};
+
+// Per-thread hashed document frequencies in a large range with many more documents.
+// The memory is bounded by the number of distinct documents found by each thread.
+class SparseDocFrequencies
+{
+  public:
+    explicit SparseDocFrequencies(usint _threads) :
+      freqs(_threads)
+    {
+    }
+
+    inline void operator()(usint thread, const usint* buffer, usint len)
+    {
+      std::unordered_map<usint, uint>& row = this->freqs[thread];
+      for(usint i = 0; i < len; i++) { row[buffer[i]]++; }
+    }
+
+    // Merges the frequencies and appends the documents in no particular order.
+    void extract(std::vector<Document>* result)
+    {
+      std::unordered_map<usint, uint>& merged = this->freqs[0];
+      for(usint t = 1; t < this->freqs.size(); t++)
+      {
+        for(std::unordered_map<usint, uint>::iterator iter = this->freqs[t].begin(); iter != this->freqs[t].end(); ++iter)
+        {
+          merged[iter->first] += iter->second;
+        }
+        std::unordered_map<usint, uint>().swap(this->freqs[t]);
+      }
+      result->reserve(result->size() + merged.size());
+      for(std::unordered_map<usint, uint>::iterator iter = merged.begin(); iter != merged.end(); ++iter)
+      {
+        result->push_back(Document(iter->first, iter->second));
+      }
+    }
+
+  private:
+    std::vector<std::unordered_map<usint, uint> > freqs;
+};
+
+}
+
 std::vector<uint>*
 bruteForceDocListUnsafe(const RLCSA* rlcsa, const CSA::ReadBuffer* docarray, pair_type sa_range, std::vector<uint>* result)
 {
   bool filter = (result == 0);
-  if(result == 0) { result = new std::vector<uint>; result->reserve(CSA::length(sa_range)); }
+  if(result == 0) { result = new std::vector<uint>; }
 
+  if(bruteForceChunks(sa_range) > 1)
+  {
+    // The bitmaps remove the duplicates, so filtering is not needed.
+    usint threads = bruteForceThreads(sa_range);
+    DocBitmaps bitmaps(threads, bruteForceDocBound(rlcsa, docarray));
+    bruteForceEngine(rlcsa, docarray, sa_range, threads, bitmaps);
+    bitmaps.merge();
+    if(filter) { result->reserve(bitmaps.count()); }
+    bitmaps.extract(result);
+    return result;
+  }
+
+  usint len = CSA::length(sa_range), offset = result->size();
+  result->resize(offset + len);
   if(docarray == 0)
   {
-    for(usint offset = sa_range.first; offset <= sa_range.second; offset += CSA::MILLION)
-    {
-      usint len = std::min(CSA::MILLION, sa_range.second + 1 - offset);
-      usint* buffer = rlcsa->getSequenceForPosition(rlcsa->locate(sa_range), len);
-      for(usint i = 0; i < len; i++) { result->push_back(buffer[i]); }
-      delete[] buffer; buffer = 0;
-    }
+    usint* buffer = new usint[len];
+    bruteForceDocs(rlcsa, docarray, sa_range.first, len, buffer);
+    for(usint i = 0; i < len; i++) { (*result)[offset + i] = buffer[i]; }
+    delete[] buffer; buffer = 0;
   }
   else
   {
-    for(usint i = sa_range.first; i <= sa_range.second; i++)
-    {
-      result->push_back(docarray->readItemConst(i));
-    }
+    for(usint i = 0; i < len; i++) { (*result)[offset + i] = docarray->readItemConst(sa_range.first + i); }
   }
 
-  if(filter) { CSA::removeDuplicates(result, false); }
+  if(filter) { drl::Dedup(*result); }
 
   return result;
 }
@@ -266,27 +494,18 @@ bruteForceDocList(const CSA::ReadBuffer& docarray, pair_type sa_range, std::vect
 usint
 bruteForceDocCountUnsafe(const RLCSA* rlcsa, const CSA::ReadBuffer* docarray, pair_type sa_range)
 {
-  std::vector<uint> result;
-
-  if(docarray == 0)
+  if(bruteForceChunks(sa_range) > 1)
   {
-    for(usint offset = sa_range.first; offset <= sa_range.second; offset += CSA::MILLION)
-    {
-      usint len = std::min(CSA::MILLION, sa_range.second + 1 - offset);
-      usint* buffer = rlcsa->getSequenceForPosition(rlcsa->locate(sa_range), len);
-      for(usint i = 0; i < len; i++) { result.push_back(buffer[i]); }
-      delete[] buffer; buffer = 0;
-    }
-  }
-  else
-  {
-    for(usint i = sa_range.first; i <= sa_range.second; i++)
-    {
-      result.push_back(docarray->readItemConst(i));
-    }
+    usint threads = bruteForceThreads(sa_range);
+    DocBitmaps bitmaps(threads, bruteForceDocBound(rlcsa, docarray));
+    bruteForceEngine(rlcsa, docarray, sa_range, threads, bitmaps);
+    bitmaps.merge();
+    return bitmaps.count();
   }
 
-  CSA::removeDuplicates(result, false);
+  std::vector<uint> result;
+  bruteForceDocListUnsafe(rlcsa, docarray, sa_range, &result);
+  drl::Dedup(result);
   return result.size();
 }
 
@@ -327,30 +546,62 @@ std::vector<Document>*
 bruteForceTopkUnsafe(const RLCSA* rlcsa, const CSA::ReadBuffer* docarray, pair_type sa_range, usint k)
 {
   std::vector<Document>* results = new std::vector<Document>;
-  results->reserve(CSA::length(sa_range));
 
-  if(docarray == 0)
+  if(bruteForceChunks(sa_range) > 1)
   {
-    for(usint offset = sa_range.first; offset <= sa_range.second; offset += CSA::MILLION)
+    // Dense histograms only if the documents are few relative to the range, with as many
+    // threads as fit in the budget. Otherwise the histograms are hashed.
+    usint threads = bruteForceThreads(sa_range), docs = bruteForceDocBound(rlcsa, docarray);
+    usint row_bytes = docs * sizeof(uint);
+    if(docs <= TOPK_DENSE_FACTOR * CSA::length(sa_range) && row_bytes <= TOPK_DENSE_BUDGET)
+    {
+      threads = std::max(std::min(threads, TOPK_DENSE_BUDGET / std::max(row_bytes, (usint)1)), (usint)1);
+      DocFrequencies freqs(threads, docs);
+      bruteForceEngine(rlcsa, docarray, sa_range, threads, freqs);
+      freqs.extract(results);
+    }
+    else
     {
-      usint len = std::min(CSA::MILLION, sa_range.second + 1 - offset);
-      usint* buffer = rlcsa->getSequenceForPosition(rlcsa->locate(sa_range), len);
-      for(usint i = 0; i < len; i++) { results->push_back(Document(buffer[i], 1)); }
-      delete[] buffer; buffer = 0;
+      SparseDocFrequencies freqs(threads);
+      bruteForceEngine(rlcsa, docarray, sa_range, threads, freqs);
+      freqs.extract(results);
     }
   }
   else
   {
-    for(usint i = sa_range.first; i <= sa_range.second; i++)
+    usint len = CSA::length(sa_range), docs = bruteForceDocBound(rlcsa, docarray);
+    usint* buffer = new usint[len];
+    bruteForceDocs(rlcsa, docarray, sa_range.first, len, buffer);
+    if(docs <= TOPK_DENSE_FACTOR * len)
+    {
+      // Dense histogram, reused by the thread and emptied after each query.
+      thread_local std::vector<uint> freqs;
+      if(freqs.size() < docs) { freqs.resize(docs, 0); }
+      for(usint i = 0; i < len; i++)
+      {
+        if(freqs[buffer[i]] == 0) { results->push_back(Document(buffer[i], 0)); }
+        freqs[buffer[i]]++;
+      }
+      for(usint i = 0; i < results->size(); i++)
+      {
+        Document& doc = (*results)[i];
+        doc.second = freqs[doc.first]; freqs[doc.first] = 0;
+      }
+    }
+    else
     {
-      results->push_back(Document(docarray->readItemConst(i), 1));
+      std::unordered_map<usint, uint> freqs; freqs.reserve(len);
+      for(usint i = 0; i < len; i++) { freqs[buffer[i]]++; }
+      results->reserve(freqs.size());
+      for(std::unordered_map<usint, uint>::iterator iter = freqs.begin(); iter != freqs.end(); ++iter)
+      {
+        results->push_back(Document(iter->first, iter->second));
+      }
     }
+    delete[] buffer; buffer = 0;
   }
 
-  sortById(results);
-  mergeDocumentRuns(results);
-  sortByFrequency(results);
-  if(results->size() > k) { results->resize(k); }
+  selectMostFrequent(results, k);
 
   return results;
 }
@@ -0,0 +1,99 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <sdsl/int_vector.hpp>
+
+#include "drl/construct_sada.h"
+#include "drl/rmq.h"
+
+
+class ConstructSadaTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t>> {
+ protected:
+  std::vector<uint32_t> da;
+  std::size_t nd = 0;
+
+  void SetUp() override {
+    auto n = std::get<0>(GetParam());
+    nd = std::get<1>(GetParam());
+
+    std::mt19937 gen(n + nd);
+    da.resize(n);
+    for (auto &&d : da) d = gen() % nd;
+  }
+
+  sdsl::int_vector<> Expected() const {
+    sdsl::int_vector<> c_array(da.size(), 0);
+    std::vector<std::size_t> prev(nd, 0);
+    for (std::size_t i = 0; i < da.size(); ++i) {
+      c_array[i] = prev[da[i]];
+      prev[da[i]] = i + 1;
+    }
+
+    return c_array;
+  }
+};
+
+
+TEST_P(ConstructSadaTest, c_array) {
+  sdsl::int_vector<> c_array;
+  drl::ConstructCArray(da, nd, c_array);
+
+  auto expected = Expected();
+  ASSERT_EQ(c_array.size(), expected.size());
+  for (std::size_t i = 0; i < da.size(); ++i) {
+    EXPECT_EQ(c_array[i], expected[i]) << "i = " << i;
+  }
+}
+
+
+TEST_P(ConstructSadaTest, c_array_small_blocks) {
+  auto get_docs = [this](std::size_t _first, std::size_t _last, auto &_result) {
+    _result.insert(_result.end(), da.begin() + _first, da.begin() + _last);
+  };
+
+  sdsl::int_vector<> c_array;
+  drl::ConstructCArray(da.size(), nd, get_docs, c_array, 7);
+
+  auto expected = Expected();
+  ASSERT_EQ(c_array.size(), expected.size());
+  for (std::size_t i = 0; i < da.size(); ++i) {
+    EXPECT_EQ(c_array[i], expected[i]) << "i = " << i;
+  }
+}
+
+
+TEST_P(ConstructSadaTest, rmq) {
+  drl::CompactBlockRMQ rmq;
+  drl::ConstructSadakaneRMQ(da, nd, rmq);
+
+  auto expected = Expected();
+  drl::CompactBlockRMQ expected_rmq(&expected);
+  ASSERT_EQ(rmq.size(), da.size());
+
+  std::mt19937 gen(7);
+  for (std::size_t q = 0; q < 500 && !da.empty(); ++q) {
+    std::size_t i = gen() % da.size(), j = gen() % da.size();
+    if (i > j) std::swap(i, j);
+
+    EXPECT_EQ(rmq(i, j), expected_rmq(i, j));
+  }
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    ConstructSada,
+    ConstructSadaTest,
+    ::testing::Values(
+        std::make_tuple(0, 1),
+        std::make_tuple(1, 1),
+        std::make_tuple(100, 3),
+        std::make_tuple(1000, 50),
+        std::make_tuple(100000, 1000),
+        std::make_tuple(5000, 100000)
+    )
+);
@@ -0,0 +1,102 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <random>
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include "drl/dedup.h"
+
+
+class DedupTest : public ::testing::TestWithParam<std::tuple<std::size_t, uint64_t>> {
+ protected:
+  std::vector<uint64_t> docs;
+  std::vector<uint64_t> expected;
+
+  void SetUp() override {
+    auto n = std::get<0>(GetParam());
+    auto nd = std::get<1>(GetParam());
+
+    std::mt19937_64 gen(n + nd);
+    docs.resize(n);
+    for (auto &&d : docs) d = gen() % nd;
+
+    std::set<uint64_t> unique(docs.begin(), docs.end());
+    expected.assign(unique.begin(), unique.end());
+  }
+
+  template<typename _Docs>
+  _Docs Docs() const {
+    return _Docs(docs.begin(), docs.end());
+  }
+
+  template<typename _Docs>
+  _Docs Expected() const {
+    return _Docs(expected.begin(), expected.end());
+  }
+};
+
+
+TEST_P(DedupTest, strategies) {
+  for (auto strategy : {drl::DedupStrategy::kSort, drl::DedupStrategy::kRadix, drl::DedupStrategy::kBitmap}) {
+    auto docs32 = Docs<std::vector<uint32_t>>();
+    drl::Dedup(docs32, strategy);
+    EXPECT_EQ(docs32, Expected<std::vector<uint32_t>>());
+
+    auto docs64 = Docs<std::vector<uint64_t>>();
+    drl::Dedup(docs64, strategy);
+    EXPECT_EQ(docs64, Expected<std::vector<uint64_t>>());
+  }
+}
+
+
+TEST_P(DedupTest, adaptive) {
+  // Twice, as the buffers are reused between calls
+  for (int i = 0; i < 2; ++i) {
+    auto docs32 = Docs<std::vector<uint32_t>>();
+    drl::Dedup(docs32);
+    EXPECT_EQ(docs32, Expected<std::vector<uint32_t>>());
+  }
+}
+
+
+TEST(DedupSparseTest, sparse_64bit) {
+  std::mt19937_64 gen(3);
+  std::vector<uint64_t> docs(20000);
+  for (auto &&d : docs) d = gen() % 5000 << 40;
+  std::set<uint64_t> unique(docs.begin(), docs.end());
+  std::vector<uint64_t> expected(unique.begin(), unique.end());
+
+  for (auto strategy : {drl::DedupStrategy::kSort, drl::DedupStrategy::kRadix}) {
+    auto tmp = docs;
+    drl::Dedup(tmp, strategy);
+    EXPECT_EQ(tmp, expected);
+  }
+
+  drl::Dedup(docs);
+  EXPECT_EQ(docs, expected);
+}
+
+
+TEST(ChooseDedupStrategyTest, choose) {
+  EXPECT_EQ(drl::ChooseDedupStrategy(100, 1000000), drl::DedupStrategy::kSort);
+  EXPECT_EQ(drl::ChooseDedupStrategy(10000, 1000), drl::DedupStrategy::kBitmap);
+  EXPECT_EQ(drl::ChooseDedupStrategy(1000, 100000000), drl::DedupStrategy::kRadix);
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    Dedup,
+    DedupTest,
+    ::testing::Values(
+        std::make_tuple(0, 1),
+        std::make_tuple(1, 1),
+        std::make_tuple(50, 10),
+        std::make_tuple(1000, 3),
+        std::make_tuple(1000, 1000000),
+        std::make_tuple(100000, 5000),
+        std::make_tuple(100000, uint64_t(1) << 28)
+    )
+);
@@ -0,0 +1,546 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/rmq_support.hpp>
+
+#include <rlcsa/rlcsa.h>
+
+#include "drl/construct_sada.h"
+#include "drl/dl_basic_scheme.h"
+#include "drl/doclist.h"
+#include "drl/reported_set.h"
+#include "drl/doc_counter.h"
+#include "drl/dl_index.h"
+
+
+/// Recursive formulation of the RMQ-based scheme (reference)
+template<typename _RMQ, typename _DA, typename _Reported>
+void ListDocsRecursive(std::size_t _bp, std::size_t _ep, const _RMQ &_rmq, const _DA &_da, _Reported &_reported,
+                       std::vector<uint32_t> &_docs) {
+  if (_bp >= _ep) return;
+
+  auto k = _rmq(_bp, _ep - 1);
+  auto d = _da[k];
+
+  if (!_reported[d]) {
+    _docs.push_back(d);
+    _reported[d] = 1;
+    ListDocsRecursive(_bp, k, _rmq, _da, _reported, _docs);
+    ListDocsRecursive(k + 1, _ep, _rmq, _da, _reported, _docs);
+  }
+}
+
+
+class DLSadakaneTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t>> {
+ protected:
+  sdsl::int_vector<> da;
+  sdsl::int_vector<> c;
+  drl::DefaultRMQ rmq;
+  std::size_t nd = 0;
+
+  void SetUp() override {
+    auto n = std::get<0>(GetParam());
+    nd = std::get<1>(GetParam());
+
+    std::mt19937 gen(n * 31 + nd);
+    da = sdsl::int_vector<>(n, 0);
+    for (auto &&d : da) d = gen() % nd;
+
+    // C[i] = 1 + position of the previous occurrence of DA[i] (0 if none)
+    drl::ConstructCArray(da, nd, c);
+
+    rmq = drl::DefaultRMQ(&c);
+  }
+
+  auto Expected(std::size_t _bp, std::size_t _ep) const {
+    return std::set<uint32_t>(da.begin() + _bp, da.begin() + _ep);
+  }
+
+  template<typename _Idx>
+  void CheckQueries(const _Idx &_idx, std::size_t _seed, std::size_t _queries) const {
+    std::mt19937 gen(_seed);
+    for (std::size_t i = 0; i < _queries; ++i) {
+      std::size_t bp = gen() % da.size(), ep = gen() % da.size();
+      if (bp > ep) std::swap(bp, ep);
+      ++ep;
+
+      auto res = _idx.list(bp, ep);
+      std::set<uint32_t> res_set(res.begin(), res.end());
+      EXPECT_EQ(res_set.size(), res.size());
+      EXPECT_EQ(res_set, Expected(bp, ep));
+    }
+  }
+};
+
+
+TEST_P(DLSadakaneTest, list) {
+  drl::GetDocDA<decltype(da)> get_doc(da);
+  auto idx = drl::BuildDLSadakane<sdsl::bit_vector>(rmq, get_doc, nd);
+
+  CheckQueries(idx, 0, 200);
+}
+
+
+TEST_P(DLSadakaneTest, list_in_recursive_order) {
+  drl::GetDocDA<decltype(da)> get_doc(da);
+  auto idx = drl::BuildDLSadakane<sdsl::bit_vector>(rmq, get_doc, nd);
+
+  std::mt19937 gen(7);
+  for (std::size_t i = 0; i < 100; ++i) {
+    std::size_t bp = gen() % da.size(), ep = gen() % da.size();
+    if (bp > ep) std::swap(bp, ep);
+    ++ep;
+
+    std::vector<uint32_t> expected;
+    sdsl::bit_vector reported(nd, 0);
+    ListDocsRecursive(bp, ep, rmq, da, reported, expected);
+
+    EXPECT_EQ(idx.list(bp, ep), expected);
+  }
+}
+
+
+TEST_P(DLSadakaneTest, list_with_batch_sizes) {
+  std::vector<uint32_t> expected;
+  sdsl::bit_vector reported(nd, 0);
+  ListDocsRecursive(0, da.size(), rmq, da, reported, expected);
+
+  for (std::size_t batch_size : {1, 2, 5, 64}) {
+    std::vector<uint32_t> docs;
+    reported = sdsl::bit_vector(nd, 0);
+    auto get_docs = [this](const auto &_positions, auto &_docs) {
+      _docs.resize(_positions.size());
+      for (std::size_t i = 0; i < _positions.size(); ++i) _docs[i] = da[_positions[i]];
+    };
+    auto is_reported = [&reported](auto _k, auto _d) { return reported[_d] == 1; };
+    auto report = [&reported, &docs](auto _k, auto _d) {
+      docs.push_back(_d);
+      reported[_d] = 1;
+    };
+
+    drl::RMQFrontier frontier;
+    drl::ListDocsRMQSchemeBatched(0, da.size(), rmq, get_docs, is_reported, report, frontier, batch_size);
+    EXPECT_EQ(docs, expected);
+  }
+}
+
+
+TEST_P(DLSadakaneTest, list_with_explicit_context) {
+  drl::GetDocDA<decltype(da)> get_doc(da);
+  auto idx = drl::BuildDLSadakane<sdsl::bit_vector>(rmq, get_doc, nd);
+
+  auto context = idx.acquireContext();
+  for (std::size_t i = 0; i < 2; ++i) {
+    auto res = idx.list(0, da.size(), *context);
+    std::set<uint32_t> res_set(res.begin(), res.end());
+    EXPECT_EQ(res_set, Expected(0, da.size()));
+  }
+}
+
+
+TEST_P(DLSadakaneTest, list_concurrently) {
+  drl::GetDocDA<decltype(da)> get_doc(da);
+  auto idx = drl::BuildDLSadakane<sdsl::bit_vector>(rmq, get_doc, nd);
+
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([this, &idx, t]() { CheckQueries(idx, t + 1, 100); });
+  }
+  for (auto &&thread : threads) thread.join();
+}
+
+
+TEST_P(DLSadakaneTest, list_into_sink_with_limit) {
+  drl::GetDocDA<decltype(da)> get_doc(da);
+  auto idx = drl::BuildDLSadakane<sdsl::bit_vector>(rmq, get_doc, nd);
+  auto idx_epoch = drl::BuildDLSadakane<drl::ReportedEpochSet<>>(rmq, get_doc, nd);
+
+  auto all = idx.list(0, da.size());
+  for (std::size_t limit : {0, 1, 3, 10, 100000}) {
+    auto n = std::min<std::size_t>(limit, all.size());
+    std::vector<uint32_t> expected(all.begin(), all.begin() + n);
+
+    std::vector<uint32_t> docs;
+    EXPECT_EQ(idx.list(0, da.size(), std::back_inserter(docs), limit), n);
+    EXPECT_EQ(docs, expected);
+
+    docs.clear();
+    auto sink = [&docs](auto _d) { docs.push_back(_d); };
+    EXPECT_EQ(idx_epoch.list(0, da.size(), sink, limit), n);
+    EXPECT_EQ(docs, expected);
+
+    // The reported sets are clean after a limited query
+    EXPECT_EQ(idx.list(0, da.size()), all);
+    EXPECT_EQ(idx_epoch.list(0, da.size()), all);
+  }
+}
+
+
+TEST_P(DLSadakaneTest, list_with_reported_sets) {
+  drl::GetDocDA<decltype(da)> get_doc(da);
+
+  CheckQueries(drl::BuildDLSadakane<drl::ReportedEpochSet<>>(rmq, get_doc, nd), 11, 100);
+  CheckQueries(drl::BuildDLSadakane<drl::ReportedEpochSet<uint8_t>>(rmq, get_doc, nd), 12, 600);
+  CheckQueries(drl::BuildDLSadakane<drl::ReportedHashSet>(rmq, get_doc, nd), 13, 100);
+  CheckQueries(drl::BuildDLSadakane<drl::ReportedAdaptiveSet<>>(rmq, get_doc, nd), 14, 100);
+}
+
+
+TEST_P(DLSadakaneTest, list_with_block_rmq) {
+  drl::GetDocDA<decltype(da)> get_doc(da);
+  drl::CompactBlockRMQ compact_rmq(&c);
+  drl::SIMDBlockRMQ simd_rmq(&c);
+
+  CheckQueries(drl::BuildDLSadakane<sdsl::bit_vector>(compact_rmq, get_doc, nd), 15, 100);
+  CheckQueries(drl::BuildDLSadakane<sdsl::bit_vector>(simd_rmq, get_doc, nd), 16, 100);
+}
+
+
+TEST_P(DLSadakaneTest, index_serialize_and_load) {
+  drl::DLSadakaneIndex<drl::DefaultRMQ, sdsl::int_vector<>, drl::ReportedEpochSet<>> idx(rmq, da, nd);
+  CheckQueries(idx, 17, 50);
+
+  std::stringstream ss;
+  idx.serialize(ss);
+
+  drl::DLSadakaneIndex<drl::DefaultRMQ, sdsl::int_vector<>, drl::ReportedEpochSet<>> loaded;
+  EXPECT_TRUE(loaded.load(ss));
+  CheckQueries(loaded, 18, 50);
+
+  // Wrong index type
+  ss.seekg(0);
+  drl::DLILCPIndex<drl::DefaultRMQ, sdsl::int_vector<>, drl::ReportedEpochSet<>> ilcp;
+  EXPECT_FALSE(ilcp.load(ss));
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    DLSadakane,
+    DLSadakaneTest,
+    ::testing::Values(
+        std::make_tuple(1, 1),
+        std::make_tuple(100, 3),
+        std::make_tuple(2000, 50),
+        std::make_tuple(5000, 1000)
+    )
+);
+
+
+/// RLCSA of random documents built in memory, with the ILCP run heads and the ranges of random patterns.
+class DLILCPTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t, std::size_t>> {
+ protected:
+  std::shared_ptr<RLCSA> rlcsa;
+  std::shared_ptr<CSA::DeltaVector> run_heads;
+  sdsl::int_vector<32> heads;
+  drl::DefaultRMQ rmq;
+  sdsl::int_vector<> da;
+  std::size_t nd = 0;
+
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+  void SetUp() override {
+    nd = std::get<0>(GetParam());
+    auto max_len = std::get<1>(GetParam());
+    auto sample_rate = std::get<2>(GetParam());
+
+    std::mt19937 gen(nd * 31 + max_len);
+    std::string text;
+    for (std::size_t d = 0; d < nd; ++d) {
+      for (std::size_t i = 0, len = 1 + gen() % max_len; i < len; ++i) text.push_back('a' + gen() % 3);
+      text.push_back('\0');
+    }
+
+    auto *data = new CSA::uchar[text.size()];
+    std::copy(text.begin(), text.end(), data);
+    rlcsa = std::make_shared<RLCSA>(data, text.size(), 32, sample_rate, 1, true);
+
+    CSA::DeltaVector *rh = nullptr;
+    heads = DoclistILCP::buildRunHeads(*rlcsa, &rh);
+    run_heads.reset(rh);
+    rmq = drl::DefaultRMQ(&heads);
+
+    da = sdsl::int_vector<>(rlcsa->getSize(), 0);
+    for (std::size_t i = 0; i < da.size(); ++i) da[i] = rlcsa->getSequenceForPosition(rlcsa->locate(i));
+
+    // Ranges of random substrings of the documents
+    for (std::size_t q = 0; q < 300; ++q) {
+      std::size_t b = gen() % text.size(), l = 1 + gen() % 6;
+      auto pattern = text.substr(b, l);
+      pattern = pattern.substr(0, pattern.find('\0'));
+      if (pattern.empty()) continue;
+
+      auto range = rlcsa->count(pattern);
+      if (range.first <= range.second) ranges.emplace_back(range.first, range.second + 1);
+    }
+  }
+
+  auto Expected(std::size_t _bp, std::size_t _ep) const {
+    return std::set<uint32_t>(da.begin() + _bp, da.begin() + _ep);
+  }
+
+  template<typename _Idx>
+  void CheckQueries(const _Idx &_idx) const {
+    for (const auto &range : ranges) {
+      auto res = _idx.list(range.first, range.second);
+      std::set<uint32_t> res_set(res.begin(), res.end());
+      EXPECT_EQ(res_set.size(), res.size()) << "Repeated documents in [" << range.first << ", " << range.second << ")";
+      EXPECT_EQ(res_set, Expected(range.first, range.second));
+    }
+  }
+};
+
+
+TEST_P(DLILCPTest, list) {
+  ASSERT_TRUE(rlcsa->isOk());
+
+  drl::GetDocDA<decltype(da)> get_doc_da(da);
+  CheckQueries(drl::BuildDLILCP<sdsl::bit_vector>(rmq, run_heads, get_doc_da, nd + 1, get_doc_da));
+  CheckQueries(drl::BuildDLILCP<drl::ReportedEpochSet<>>(rmq, run_heads, get_doc_da, nd + 1, get_doc_da));
+}
+
+
+TEST_P(DLILCPTest, list_with_batched_get_docs) {
+  // The run heads are located in batches (GetDocRLCSA::GetDocs) and the runs as RLCSA ranges
+  drl::GetDocRLCSA get_doc(rlcsa);
+  CheckQueries(drl::BuildDLILCP<sdsl::bit_vector>(rmq, run_heads, get_doc, nd + 1, get_doc));
+  CheckQueries(drl::BuildDLILCP<drl::ReportedHashSet>(rmq, run_heads, get_doc, nd + 1, get_doc));
+
+  drl::GetDocRLCSA get_doc_no_gaps(rlcsa, 0);
+  CheckQueries(drl::BuildDLILCP<sdsl::bit_vector>(rmq, run_heads, get_doc_no_gaps, nd + 1, get_doc_no_gaps));
+}
+
+
+TEST_P(DLILCPTest, list_with_explicit_context) {
+  drl::GetDocRLCSA get_doc(rlcsa);
+  auto idx = drl::BuildDLILCP<drl::ReportedEpochSet<>>(rmq, run_heads, get_doc, nd + 1, get_doc);
+
+  auto context = idx.acquireContext();
+  for (std::size_t i = 0; i < 2; ++i) {
+    for (const auto &range : ranges) {
+      auto res = idx.list(range.first, range.second, *context);
+      EXPECT_EQ(std::set<uint32_t>(res.begin(), res.end()), Expected(range.first, range.second));
+    }
+  }
+}
+
+
+TEST_P(DLILCPTest, list_concurrently) {
+  // Concurrent queries on the same scheme, so they share its pool of contexts
+  drl::GetDocRLCSA get_doc(rlcsa);
+  auto idx = drl::BuildDLILCP<drl::ReportedEpochSet<>>(rmq, run_heads, get_doc, nd + 1, get_doc);
+
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([this, &idx]() {
+      for (std::size_t i = 0; i < 3; ++i) CheckQueries(idx);
+    });
+  }
+  for (auto &&thread : threads) thread.join();
+}
+
+
+TEST_P(DLILCPTest, list_into_sink_with_limit) {
+  drl::GetDocRLCSA get_doc(rlcsa);
+  auto idx = drl::BuildDLILCP<drl::ReportedEpochSet<>>(rmq, run_heads, get_doc, nd + 1, get_doc);
+
+  for (const auto &range : ranges) {
+    auto expected = Expected(range.first, range.second);
+    for (std::size_t limit : {1, 2, 100000}) {
+      std::vector<uint32_t> docs;
+      EXPECT_EQ(idx.list(range.first, range.second, std::back_inserter(docs), limit),
+                std::min(limit, expected.size()));
+      EXPECT_EQ(docs.size(), std::min(limit, expected.size()));
+      for (const auto &d : docs) EXPECT_EQ(expected.count(d), 1);
+    }
+
+    // The reported set is clean after a limited query
+    auto res = idx.list(range.first, range.second);
+    EXPECT_EQ(std::set<uint32_t>(res.begin(), res.end()), expected);
+  }
+}
+
+
+TEST_P(DLILCPTest, index_serialize_and_load) {
+  drl::DLILCPIndex<drl::DefaultRMQ, sdsl::int_vector<>, drl::ReportedEpochSet<>> idx(rmq, run_heads, da, nd + 1);
+  CheckQueries(idx);
+
+  std::stringstream ss;
+  idx.serialize(ss);
+
+  drl::DLILCPIndex<drl::DefaultRMQ, sdsl::int_vector<>, drl::ReportedEpochSet<>> loaded;
+  EXPECT_TRUE(loaded.load(ss));
+  CheckQueries(loaded);
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    DLILCP,
+    DLILCPTest,
+    ::testing::Values(
+        std::make_tuple(1, 50, 4),
+        std::make_tuple(5, 30, 4),
+        std::make_tuple(20, 100, 8),
+        std::make_tuple(50, 17, 16)
+    )
+);
+
+
+/// Generalized suffix array of random documents, with distinct terminators, and its pattern ranges.
+class DocCounterTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t, std::size_t>> {
+ protected:
+  sdsl::int_vector<> sa;
+  sdsl::int_vector<> da;
+  sdsl::int_vector<> lcp;
+  sdsl::int_vector<> c;
+  std::size_t nd = 0;
+
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+  void SetUp() override {
+    nd = std::get<0>(GetParam());
+    auto doc_len = std::get<1>(GetParam());
+    auto sigma = std::get<2>(GetParam());
+
+    // Terminator of document d is d, so they are distinct and smaller than the letters
+    std::mt19937 gen(nd * 31 + doc_len);
+    std::vector<uint32_t> text, doc_of;
+    for (std::size_t d = 0; d < nd; ++d) {
+      for (std::size_t i = 0, len = 1 + gen() % doc_len; i < len; ++i) {
+        text.push_back(nd + gen() % sigma);
+        doc_of.push_back(d);
+      }
+      text.push_back(d);
+      doc_of.push_back(d);
+    }
+    auto n = text.size();
+
+    std::vector<std::size_t> suffixes(n);
+    std::iota(suffixes.begin(), suffixes.end(), 0);
+    std::sort(suffixes.begin(), suffixes.end(), [&text](auto a, auto b) {
+      return std::lexicographical_compare(text.begin() + a, text.end(), text.begin() + b, text.end());
+    });
+
+    auto lcp_of = [&text, n](std::size_t a, std::size_t b) {
+      std::size_t l = 0;
+      while (a + l < n && b + l < n && text[a + l] == text[b + l]) ++l;
+      return l;
+    };
+
+    sa = sdsl::int_vector<>(n, 0);
+    da = sdsl::int_vector<>(n, 0);
+    lcp = sdsl::int_vector<>(n, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+      sa[i] = suffixes[i];
+      da[i] = doc_of[suffixes[i]];
+      lcp[i] = i ? lcp_of(suffixes[i - 1], suffixes[i]) : 0;
+    }
+    drl::ConstructCArray(da, nd, c);
+
+    // Ranges of all the patterns (suffix tree nodes and leaves)
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t l = 1; sa[i] + l <= n && text[sa[i] + l - 1] >= nd; ++l) {
+        auto bp = i, ep = i + 1;
+        while (bp > 0 && lcp[bp] >= l) --bp;
+        while (ep < n && lcp[ep] >= l) ++ep;
+        ranges.emplace_back(bp, ep);
+      }
+      ranges.emplace_back(i, i + 1);
+    }
+    std::sort(ranges.begin(), ranges.end());
+    ranges.erase(std::unique(ranges.begin(), ranges.end()), ranges.end());
+  }
+
+  auto Expected(std::size_t _bp, std::size_t _ep) const {
+    return std::set<uint32_t>(da.begin() + _bp, da.begin() + _ep).size();
+  }
+};
+
+
+TEST_P(DocCounterTest, count) {
+  drl::DocCounter counter(c, lcp);
+
+  for (const auto &range : ranges) {
+    EXPECT_EQ(counter.count(range.first, range.second), Expected(range.first, range.second));
+  }
+  EXPECT_EQ(counter.count(3, 3), 0);
+}
+
+
+TEST_P(DocCounterTest, count_with_scheme) {
+  drl::DefaultRMQ rmq(&c);
+  drl::GetDocDA<decltype(da)> get_doc(da);
+  auto idx = drl::BuildDLSadakane<sdsl::bit_vector>(rmq, get_doc, nd);
+
+  for (const auto &range : ranges) {
+    EXPECT_EQ(idx.count(range.first, range.second), Expected(range.first, range.second));
+  }
+
+  idx.setCounter(std::make_shared<drl::DocCounter>(c, lcp));
+  for (const auto &range : ranges) {
+    EXPECT_EQ(idx.count(range.first, range.second), Expected(range.first, range.second));
+  }
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    DocCounter,
+    DocCounterTest,
+    ::testing::Values(
+        std::make_tuple(1, 10, 2),
+        std::make_tuple(5, 20, 2),
+        std::make_tuple(20, 15, 3),
+        std::make_tuple(10, 30, 1)
+    )
+);
+
+
+template<typename _Reported>
+class ReportedSetTest : public ::testing::Test {};
+
+using ReportedSetTypes = ::testing::Types<sdsl::bit_vector,
+                                          drl::ReportedEpochSet<>,
+                                          drl::ReportedEpochSet<uint8_t>,
+                                          drl::ReportedHashSet,
+                                          drl::ReportedAdaptiveSet<>>;
+TYPED_TEST_CASE(ReportedSetTest, ReportedSetTypes);
+
+
+TYPED_TEST(ReportedSetTest, set_and_reset) {
+  using Traits = drl::ReportedTraits<TypeParam>;
+  const std::size_t nd = 1000;
+
+  auto reported = Traits::Build(nd);
+  std::mt19937 gen(3);
+
+  // More queries than the epochs of 8-bit stamps
+  for (std::size_t q = 0; q < 600; ++q) {
+    auto expected = q % 2 ? 5 : nd;
+    Traits::Prepare(reported, expected);
+
+    std::set<uint32_t> docs;
+    for (std::size_t i = 0; i < expected; ++i) {
+      auto d = gen() % nd;
+      EXPECT_EQ(Traits::Test(reported, d), docs.count(d) == 1);
+      if (docs.insert(d).second) Traits::Set(reported, d);
+    }
+
+    for (std::size_t d = 0; d < nd; ++d) {
+      EXPECT_EQ(Traits::Test(reported, d), docs.count(d) == 1);
+    }
+
+    Traits::Reset(reported, docs);
+  }
+}
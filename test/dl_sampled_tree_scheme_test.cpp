@@ -0,0 +1,189 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "drl/dl_sampled_tree_scheme.h"
+
+
+/// Cover of [_sp, _ep): the nodes are the blocks of kBlockSize fully inside the range
+class ComputeCoverBlocks {
+ public:
+  static const std::size_t kBlockSize = 100;
+
+  auto operator()(std::size_t _sp, std::size_t _ep) const {
+    auto first = (_sp + kBlockSize - 1) / kBlockSize, last = _ep / kBlockSize;
+
+    std::vector<std::size_t> nodes;
+    for (auto b = first; b < last; ++b) nodes.push_back(b);
+
+    if (nodes.empty()) return std::make_pair(std::make_pair(_ep, _ep), nodes);
+
+    return std::make_pair(std::make_pair(first * kBlockSize, last * kBlockSize), nodes);
+  }
+};
+
+
+/// Documents of a document array, counting the located positions
+class GetDocsCounting {
+ public:
+  explicit GetDocsCounting(const std::vector<uint32_t> &_da) : da_{_da} {}
+
+  template<typename _Report>
+  void operator()(std::size_t _b, std::size_t _e, _Report &_report) const {
+    for (auto i = _b; i < _e; ++i) {
+      _report(da_[i]);
+    }
+    located += _e - _b;
+  }
+
+  mutable std::size_t located = 0;
+
+ private:
+  const std::vector<uint32_t> &da_;
+};
+
+
+/// Sets of the blocks (as containers), counting the reported documents
+class BlockSets {
+ public:
+  explicit BlockSets(const std::vector<uint32_t> &_da) {
+    for (std::size_t b = 0; b * ComputeCoverBlocks::kBlockSize < _da.size(); ++b) {
+      auto first = _da.begin() + b * ComputeCoverBlocks::kBlockSize;
+      std::set<uint32_t> set(first, first + ComputeCoverBlocks::kBlockSize);
+      sets_.emplace_back(set.begin(), set.end());
+    }
+  }
+
+  const std::vector<uint32_t> &operator[](std::size_t _i) const {
+    return sets_[_i];
+  }
+
+ protected:
+  std::vector<std::vector<uint32_t>> sets_;
+};
+
+
+/// Sets of the blocks supporting addBlocksUntil
+class BlockSetsUntil : public BlockSets {
+ public:
+  using BlockSets::BlockSets;
+
+  template<typename _Report, typename _Stop>
+  void addBlocksUntil(std::size_t _first, std::size_t _number, _Report &_report, const _Stop &_stop) const {
+    for (auto b = _first; b < _first + _number; ++b) {
+      for (auto it = sets_[b].begin(); it != sets_[b].end() && !_stop(); ++it) {
+        _report(*it);
+        ++reported;
+      }
+    }
+  }
+
+  mutable std::size_t reported = 0;
+};
+
+
+struct MergeSetsNone {
+  template<typename _II, typename _GetDocSet, typename _Docs>
+  void operator()(_II, _II, const _GetDocSet &, _Docs &) const {}
+};
+
+
+class DLSampledTreeSchemeTest : public ::testing::TestWithParam<std::tuple<std::size_t, uint32_t>> {
+ protected:
+  std::vector<uint32_t> da;
+
+  void SetUp() override {
+    auto n = std::get<0>(GetParam());
+    auto nd = std::get<1>(GetParam());
+
+    std::mt19937 gen(n + nd);
+    da.resize(n);
+    for (auto &&d : da) d = gen() % nd;
+  }
+
+  std::set<uint32_t> Expected(std::size_t _sp, std::size_t _ep) const {
+    return std::set<uint32_t>(da.begin() + _sp, da.begin() + _ep);
+  }
+};
+
+
+TEST_P(DLSampledTreeSchemeTest, list_with_limit) {
+  ComputeCoverBlocks compute_cover;
+  GetDocsCounting get_docs(da);
+  BlockSets sets(da);
+  MergeSetsNone merge;
+  auto dl = drl::BuildDLSampledTreeScheme(compute_cover, get_docs, sets, merge);
+
+  std::mt19937 gen(da.size());
+  for (std::size_t q = 0; q < 200; ++q) {
+    std::size_t sp = gen() % da.size(), ep = gen() % da.size();
+    if (sp > ep) std::swap(sp, ep);
+    ++ep;
+
+    auto expected = Expected(sp, ep);
+    for (std::size_t limit : {std::size_t(1), std::size_t(5), expected.size(), drl::kNoLimit}) {
+      std::vector<uint32_t> docs;
+      auto n = dl.list(sp, ep, std::back_inserter(docs), limit);
+
+      EXPECT_EQ(n, std::min(limit, expected.size()));
+      EXPECT_EQ(docs.size(), n);
+      EXPECT_EQ(std::set<uint32_t>(docs.begin(), docs.end()).size(), n) << "Repeated documents";
+      for (const auto &d : docs) {
+        EXPECT_TRUE(expected.count(d)) << d << " not in [" << sp << ", " << ep << ")";
+      }
+    }
+  }
+}
+
+
+TEST_P(DLSampledTreeSchemeTest, list_stops_locating_borders) {
+  ComputeCoverBlocks compute_cover;
+  GetDocsCounting get_docs(da);
+  BlockSets sets(da);
+  MergeSetsNone merge;
+  auto dl = drl::BuildDLSampledTreeScheme(compute_cover, get_docs, sets, merge);
+
+  // Range without cover nodes, which is located completely in the borders
+  std::size_t sp = 1, ep = std::min<std::size_t>(da.size(), ComputeCoverBlocks::kBlockSize - 1);
+  std::vector<uint32_t> docs;
+  dl.list(sp, ep, std::back_inserter(docs), 1);
+
+  EXPECT_EQ(docs.size(), 1);
+  EXPECT_LE(get_docs.located, drl::kMinBorderChunkSize);
+}
+
+
+TEST_P(DLSampledTreeSchemeTest, list_stops_expanding_sets) {
+  ComputeCoverBlocks compute_cover;
+  GetDocsCounting get_docs(da);
+  BlockSetsUntil sets(da);
+  MergeSetsNone merge;
+  auto dl = drl::BuildDLSampledTreeScheme(compute_cover, get_docs, sets, merge);
+
+  // Range covered by the blocks, without borders
+  std::size_t limit = 3;
+  std::vector<uint32_t> docs;
+  dl.list(0, da.size(), std::back_inserter(docs), limit);
+
+  EXPECT_EQ(docs.size(), limit);
+  EXPECT_EQ(get_docs.located, 0);
+  EXPECT_EQ(sets.reported, limit);
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    DLSampledTreeScheme,
+    DLSampledTreeSchemeTest,
+    ::testing::Values(
+        std::make_tuple(1000, 10),
+        std::make_tuple(2000, 1000),
+        std::make_tuple(5000, 50)
+    )
+);
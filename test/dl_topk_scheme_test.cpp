@@ -0,0 +1,372 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <omp.h>
+
+#include <rlcsa/rlcsa.h>
+
+#include "drl/dl_topk_scheme.h"
+#include "drl/dl_basic_scheme.h"
+#include "drl/pdltree.h"
+#include "drl/pdl_suffix_tree.h"
+#include "drl/utils.h"
+
+
+/// Sampled tree with one node per block of the document array, storing its documents sorted by frequency.
+class DLTopKTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t, std::size_t>> {
+ protected:
+  std::vector<uint32_t> da;
+  std::size_t block_size = 0;
+  std::vector<std::vector<drl::DocFreq>> sets;
+
+  void SetUp() override {
+    auto n = std::get<0>(GetParam());
+    auto nd = std::get<1>(GetParam());
+    block_size = std::get<2>(GetParam());
+
+    std::mt19937 gen(n + nd);
+    std::geometric_distribution<uint32_t> dist(0.2);
+    da.resize(n);
+    for (auto &&d : da) d = dist(gen) % nd;
+
+    for (std::size_t i = 0; i + block_size <= n; i += block_size) {
+      sets.emplace_back(Expected(i, i + block_size, nd));
+    }
+  }
+
+  std::vector<drl::DocFreq> Expected(std::size_t _sp, std::size_t _ep, std::size_t _k) const {
+    std::map<uint32_t, uint32_t> freqs;
+    for (auto i = _sp; i < _ep; ++i) ++freqs[da[i]];
+
+    std::vector<drl::DocFreq> res(freqs.begin(), freqs.end());
+    std::sort(res.begin(), res.end(), drl::DocFreqGreater());
+    res.resize(std::min(_k, res.size()));
+
+    return res;
+  }
+
+  auto Build() const {
+    auto compute_cover = [this](std::size_t _sp, std::size_t _ep) {
+      std::vector<std::size_t> nodes;
+      auto first = (_sp + block_size - 1) / block_size;
+      for (auto node = first; (node + 1) * block_size <= _ep; ++node) nodes.push_back(node);
+
+      auto range = nodes.empty() ? std::make_pair(_ep, _ep)
+                                 : std::make_pair(nodes.front() * block_size, (nodes.back() + 1) * block_size);
+      return std::make_pair(range, nodes);
+    };
+    auto get_docs = [this](std::size_t _bp, std::size_t _ep, auto &_report) {
+      for (auto i = _bp; i < _ep; ++i) _report(da[i]);
+    };
+    auto get_doc_freqs = [this](std::size_t _node, std::size_t _limit, auto &_report) {
+      const auto &set = sets[_node];
+      for (std::size_t i = 0; i < set.size() && i < _limit; ++i) _report(set[i].first, set[i].second);
+    };
+
+    return std::make_tuple(compute_cover, get_docs, get_doc_freqs);
+  }
+};
+
+
+TEST_P(DLTopKTest, topk) {
+  auto functors = Build();
+  auto idx = drl::BuildDLTopK(std::get<0>(functors), std::get<1>(functors), std::get<2>(functors));
+
+  std::mt19937 gen(5);
+  for (std::size_t i = 0; i < 200; ++i) {
+    std::size_t sp = gen() % da.size(), ep = gen() % da.size();
+    if (sp > ep) std::swap(sp, ep);
+    ++ep;
+
+    for (std::size_t k : {1, 3, 10, 1000}) {
+      EXPECT_EQ(idx.topk(sp, ep, k), Expected(sp, ep, k));
+    }
+  }
+}
+
+
+TEST_P(DLTopKTest, topk_of_node) {
+  auto functors = Build();
+  auto idx = drl::BuildDLTopK(std::get<0>(functors), std::get<1>(functors), std::get<2>(functors));
+
+  for (std::size_t node = 0; node < sets.size(); ++node) {
+    auto sp = node * block_size, ep = sp + block_size;
+    for (std::size_t k : {0, 1, 5, 1000}) {
+      EXPECT_EQ(idx.topk(sp, ep, k), Expected(sp, ep, k));
+    }
+  }
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    DLTopK,
+    DLTopKTest,
+    ::testing::Values(
+        std::make_tuple(1, 1, 1),
+        std::make_tuple(100, 5, 10),
+        std::make_tuple(2000, 100, 64),
+        std::make_tuple(5000, 30, 7)
+    )
+);
+
+
+TEST(DLTopK, topk_reads_prefixes_of_the_sets) {
+  // Blocks of 64 positions where document 0 occurs 32 times and 32 other documents once
+  const std::size_t block_size = 64, n_blocks = 100;
+  std::vector<std::vector<drl::DocFreq>> sets(n_blocks);
+  std::size_t total = 0;
+  for (auto &set : sets) {
+    set.emplace_back(0, 32);
+    for (uint32_t d = 1; d <= 32; ++d) set.emplace_back(d, 1);
+    total += set.size();
+  }
+
+  auto compute_cover = [&](std::size_t _sp, std::size_t _ep) {
+    std::vector<std::size_t> nodes;
+    for (std::size_t node = 0; node < n_blocks; ++node) nodes.push_back(node);
+    return std::make_pair(std::make_pair(_sp, _ep), nodes);
+  };
+  auto get_docs = [](std::size_t _bp, std::size_t _ep, auto &_report) {};
+  std::size_t read = 0;
+  auto get_doc_freqs = [&](std::size_t _node, std::size_t _limit, auto &_report) {
+    const auto &set = sets[_node];
+    for (std::size_t i = 0; i < set.size() && i < _limit; ++i, ++read) _report(set[i].first, set[i].second);
+  };
+  auto idx = drl::BuildDLTopK(compute_cover, get_docs, get_doc_freqs);
+
+  std::vector<drl::DocFreq> expected = {{0, 32 * n_blocks}};
+  EXPECT_EQ(idx.topk(0, block_size * n_blocks, 1), expected);
+  EXPECT_LT(read, total / 4);
+
+  expected.emplace_back(1, n_blocks);
+  read = 0;
+  EXPECT_EQ(idx.topk(0, block_size * n_blocks, 2), expected);
+}
+
+/// Sets of the PDL tree nodes written by PDLTree::writeSets, each one ended by a unique endmarker
+class PlainNodeSets {
+ public:
+  PlainNodeSets(FILE *_input, usint _nd) {
+    uint value;
+    sets_.emplace_back();
+    while (std::fread(&value, sizeof(value), 1, _input) == 1) {
+      if (value > _nd) sets_.emplace_back();
+      else sets_.back().push_back(value);
+    }
+    sets_.pop_back();
+  }
+
+  template<typename _Report>
+  void addBlocks(usint _first, usint _number, _Report &_report, std::size_t _limit = drl::kNoLimit) const {
+    std::size_t reported = 0;
+    for (auto node = _first; node < _first + _number; ++node) {
+      for (auto it = sets_[node].begin(); it != sets_[node].end() && reported < _limit; ++it, ++reported) {
+        _report(*it);
+      }
+    }
+  }
+
+  std::size_t size() const {
+    return sets_.size();
+  }
+
+ private:
+  std::vector<std::vector<uint>> sets_;
+};
+
+
+/// PDL tree (mode_topk) of random documents, built on an RLCSA in memory, and the ranges of random patterns.
+class PDLTopKTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t, std::size_t, bool>> {
+ protected:
+  std::shared_ptr<RLCSA> rlcsa;
+  std::unique_ptr<PDLTree> tree;
+  std::unique_ptr<CSA::DeltaMultiArray> freqs;
+  std::unique_ptr<PlainNodeSets> sets;
+  usint block_size = 0;
+  bool differential = false;
+
+  std::vector<CSA::pair_type> ranges;
+
+  void SetUp() override {
+    auto nd = std::get<0>(GetParam());
+    auto max_len = std::get<1>(GetParam());
+    block_size = std::get<2>(GetParam());
+    differential = std::get<3>(GetParam());
+
+    // Documents with few distinct letters, so the frequencies have many ties
+    std::mt19937 gen(nd * 31 + max_len);
+    std::string text;
+    for (std::size_t d = 0; d < nd; ++d) {
+      for (std::size_t i = 0, len = 1 + gen() % max_len; i < len; ++i) text.push_back('a' + gen() % 3);
+      text.push_back('\0');
+    }
+
+    auto *data = new CSA::uchar[text.size()];
+    std::copy(text.begin(), text.end(), data);
+    rlcsa = std::make_shared<RLCSA>(data, text.size(), 32, 4, 1, true);
+
+    tree.reset(new PDLTree(*rlcsa, block_size, 4, PDLTree::mode_topk));
+    freqs.reset(tree->getFrequencies(differential));
+
+    FILE *sets_file = std::tmpfile();
+    tree->writeSets(*sets_file);
+    std::rewind(sets_file);
+    sets.reset(new PlainNodeSets(sets_file, nd));
+    std::fclose(sets_file);
+    tree->deleteNodes();
+
+    for (std::size_t q = 0; q < 300; ++q) {
+      std::size_t b = gen() % text.size(), l = 1 + gen() % 4;
+      auto pattern = text.substr(b, l);
+      pattern = pattern.substr(0, pattern.find('\0'));
+      if (pattern.empty()) continue;
+
+      auto range = rlcsa->count(pattern);
+      if (!CSA::isEmpty(range)) ranges.emplace_back(range);
+    }
+  }
+
+  std::vector<drl::DocFreq> Expected(CSA::pair_type _range, usint _k) const {
+    std::unique_ptr<std::vector<Document>> docs(bruteForceTopk(*rlcsa, _range, _k));
+    return std::vector<drl::DocFreq>(docs->begin(), docs->end());
+  }
+};
+
+
+TEST_P(PDLTopKTest, doc_freqs_of_nodes) {
+  ASSERT_TRUE(rlcsa->isOk());
+  ASSERT_TRUE(tree->isOk());
+  ASSERT_NE(freqs, nullptr);
+  ASSERT_EQ(sets->size(), tree->getNumberOfNodes());
+
+  auto compute_cover = drl::BuildComputeCoverSuffixTreeFunctor(*tree);
+  auto get_doc_freqs = drl::BuildGetDocFreqsSuffixTree(*sets, *freqs, differential);
+
+  // Ranges that are exactly a sampled node: its set is their top-k
+  std::size_t nodes_checked = 0;
+  for (const auto &range : ranges) {
+    auto cover = compute_cover(range.first, range.second + 1);
+    if (cover.second.size() != 1 || cover.first.first != range.first || cover.first.second != range.second + 1) {
+      continue;
+    }
+    ++nodes_checked;
+
+    for (usint k : {1, 3, 1000}) {
+      std::vector<drl::DocFreq> res;
+      auto report = [&res](auto _d, auto _f) { res.emplace_back(_d, _f); };
+      get_doc_freqs(cover.second.front(), k, report);
+
+      EXPECT_EQ(res, Expected(range, k)) << "Node " << cover.second.front() << ", k = " << k;
+    }
+  }
+  EXPECT_GT(nodes_checked, 0);
+}
+
+
+TEST_P(PDLTopKTest, topk) {
+  auto compute_cover = drl::BuildComputeCoverSuffixTreeFunctor(*tree);
+  drl::GetDocRLCSA get_docs(rlcsa);
+  auto get_doc_freqs = drl::BuildGetDocFreqsSuffixTree(*sets, *freqs, differential);
+  auto idx = drl::BuildDLTopK(compute_cover, get_docs, get_doc_freqs);
+
+  for (const auto &range : ranges) {
+    for (usint k : {1, 5, 1000}) {
+      EXPECT_EQ(idx.topk(range.first, range.second + 1, k), Expected(range, k))
+                << "[" << range.first << ", " << range.second << "], k = " << k;
+    }
+  }
+}
+
+
+/// Tree structure and sets of a PDL tree built with the given number of threads, as written to files
+std::pair<std::vector<char>, std::vector<char>> BuildTreeFiles(const RLCSA &_rlcsa,
+                                                               usint _block_size,
+                                                               PDLTree::mode_type _mode,
+                                                               int _threads) {
+  auto read_all = [](FILE *_file) {
+    std::vector<char> bytes;
+    std::rewind(_file);
+    for (int c = std::fgetc(_file); c != EOF; c = std::fgetc(_file)) bytes.push_back(static_cast<char>(c));
+    std::fclose(_file);
+    return bytes;
+  };
+
+  auto max_threads = omp_get_max_threads();
+  omp_set_num_threads(_threads);
+  PDLTree tree(_rlcsa, _block_size, 4, _mode);
+  omp_set_num_threads(max_threads);
+
+  FILE *tree_file = std::tmpfile();
+  tree.writeTo(tree_file);
+  FILE *sets_file = std::tmpfile();
+  tree.writeSets(*sets_file);
+
+  return {read_all(tree_file), read_all(sets_file)};
+}
+
+
+TEST_P(PDLTopKTest, parallel_sets) {
+  for (auto mode : {PDLTree::mode_rp, PDLTree::mode_topk, PDLTree::mode_count}) {
+    auto sequential = BuildTreeFiles(*rlcsa, block_size, mode, 1);
+    auto parallel = BuildTreeFiles(*rlcsa, block_size, mode, 4);
+
+    EXPECT_EQ(parallel.first, sequential.first) << "Mode " << mode;
+    EXPECT_EQ(parallel.second, sequential.second) << "Mode " << mode;
+  }
+}
+
+
+TEST_P(PDLTopKTest, fast_layout) {
+  // The same tree loaded with the compressed structures and with the fast layout
+  FILE *tree_file = std::tmpfile();
+  tree->writeTo(tree_file);
+  std::rewind(tree_file);
+  PDLTree slow(*rlcsa, tree_file, false);
+  std::rewind(tree_file);
+  PDLTree fast(*rlcsa, tree_file, true);
+  std::fclose(tree_file);
+
+  ASSERT_TRUE(slow.isOk());
+  ASSERT_TRUE(fast.isOk());
+  ASSERT_FALSE(slow.hasFastLayout());
+  ASSERT_TRUE(fast.hasFastLayout());
+  ASSERT_EQ(fast.getNumberOfNodes(), slow.getNumberOfNodes());
+
+  for (usint sp = 0; sp < rlcsa->getSize(); ++sp) {
+    for (usint ep = sp; ep < rlcsa->getSize(); ++ep) {
+      CSA::pair_type range(sp, ep);
+      ASSERT_EQ(fast.getFirstBlock(range), slow.getFirstBlock(range)) << "[" << sp << ", " << ep << "]";
+      ASSERT_EQ(fast.getLastBlock(range), slow.getLastBlock(range)) << "[" << sp << ", " << ep << "]";
+      ASSERT_EQ(fast.getNextBlock(range), slow.getNextBlock(range)) << "[" << sp << ", " << ep << "]";
+      ASSERT_EQ(fast.getBlock(range), slow.getBlock(range)) << "[" << sp << ", " << ep << "]";
+    }
+  }
+
+  for (usint block = 0; block < slow.getNumberOfLeaves(); ++block) {
+    for (usint next_leaf = block + 1; next_leaf <= slow.getNumberOfLeaves(); ++next_leaf) {
+      ASSERT_EQ(fast.getAncestor(block, next_leaf), slow.getAncestor(block, next_leaf))
+                << "Block " << block << ", next leaf " << next_leaf;
+    }
+  }
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    PDLTopK,
+    PDLTopKTest,
+    ::testing::Values(
+        std::make_tuple(5, 60, 8, false),
+        std::make_tuple(5, 60, 8, true),
+        std::make_tuple(30, 40, 16, false),
+        std::make_tuple(30, 40, 16, true)
+    )
+);
@@ -0,0 +1,101 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rlcsa/rlcsa.h>
+
+#include "drl/doclist.h"
+
+
+/// ILCP run heads built from the full ILCP array, indexed by the ranks of the document suffix arrays (reference)
+sdsl::int_vector<32> BuildRunHeadsWithRanks(const RLCSA &_rlcsa, std::vector<usint> &_run_heads) {
+  std::vector<uint> ilcp(_rlcsa.getSize());
+  for (usint i = 0; i < _rlcsa.getNumberOfSequences(); ++i) {
+    CSA::SuffixArray *sa = _rlcsa.getSuffixArrayForSequence(i);
+    uint *plcp = sa->getLCPArray(true);
+    for (usint j = 0; j < sa->getSize(); ++j) {
+      ilcp[sa->getRanks()[j] - _rlcsa.getNumberOfSequences()] = plcp[j];
+    }
+    delete[] plcp;
+    delete sa;
+  }
+
+  std::vector<uint> heads;
+  for (usint i = 0; i < ilcp.size(); ++i) {
+    if (i == 0 || ilcp[i] != ilcp[i - 1]) {
+      heads.push_back(ilcp[i]);
+      _run_heads.push_back(i);
+    }
+  }
+
+  sdsl::int_vector<32> result(heads.size());
+  for (usint i = 0; i < heads.size(); ++i) result[i] = heads[i];
+  return result;
+}
+
+
+/// RLCSA of random documents (lengths not multiple of the sample rate), built in memory.
+class DoclistILCPTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t, std::size_t>> {
+ protected:
+  std::unique_ptr<RLCSA> rlcsa;
+
+  void SetUp() override {
+    auto nd = std::get<0>(GetParam());
+    auto max_len = std::get<1>(GetParam());
+    auto sample_rate = std::get<2>(GetParam());
+
+    std::mt19937 gen(nd * 31 + max_len);
+    std::string text;
+    for (std::size_t d = 0; d < nd; ++d) {
+      auto len = 1 + gen() % max_len;
+      if (len % sample_rate == 0) ++len;
+      for (std::size_t i = 0; i < len; ++i) text.push_back('a' + gen() % 3);
+      text.push_back('\0');
+    }
+
+    auto *data = new CSA::uchar[text.size()];
+    std::copy(text.begin(), text.end(), data);
+    rlcsa.reset(new RLCSA(data, text.size(), 32, sample_rate, 1, true));
+  }
+};
+
+
+TEST_P(DoclistILCPTest, build_run_heads) {
+  ASSERT_TRUE(rlcsa->isOk());
+
+  std::vector<usint> expected_run_heads;
+  auto expected = BuildRunHeadsWithRanks(*rlcsa, expected_run_heads);
+
+  CSA::DeltaVector *run_heads = 0;
+  auto heads = DoclistILCP::buildRunHeads(*rlcsa, &run_heads);
+  ASSERT_NE(run_heads, nullptr);
+
+  EXPECT_EQ(std::vector<uint>(heads.begin(), heads.end()), std::vector<uint>(expected.begin(), expected.end()));
+
+  EXPECT_EQ(run_heads->getNumberOfItems(), expected_run_heads.size());
+  CSA::DeltaVector::Iterator iter(*run_heads);
+  for (usint i = 0; i < expected_run_heads.size(); ++i) {
+    EXPECT_EQ(iter.select(i), expected_run_heads[i]);
+  }
+
+  delete run_heads;
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    DoclistILCP,
+    DoclistILCPTest,
+    ::testing::Values(
+        std::make_tuple(1, 50, 4),
+        std::make_tuple(5, 30, 4),
+        std::make_tuple(20, 100, 8),
+        std::make_tuple(50, 17, 16)
+    )
+);
@@ -0,0 +1,100 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rlcsa/rlcsa.h>
+
+#include "drl/pdlcount.h"
+#include "drl/utils.h"
+
+
+/// RLCSA of random documents built in memory, and the ranges of all the patterns of up to five letters in it.
+class PDLCountTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t, std::size_t>> {
+ protected:
+  std::unique_ptr<RLCSA> rlcsa;
+  usint block_size = 0;
+
+  std::vector<std::string> patterns;
+
+  void SetUp() override {
+    auto nd = std::get<0>(GetParam());
+    auto max_len = std::get<1>(GetParam());
+    block_size = std::get<2>(GetParam());
+
+    std::mt19937 gen(nd * 31 + max_len);
+    std::string text;
+    for (std::size_t d = 0; d < nd; ++d) {
+      for (std::size_t i = 0, len = 1 + gen() % max_len; i < len; ++i) text.push_back('a' + gen() % 3);
+      text.push_back('\0');
+    }
+
+    auto *data = new CSA::uchar[text.size()];
+    std::copy(text.begin(), text.end(), data);
+    rlcsa.reset(new RLCSA(data, text.size(), 32, 4, 1, true));
+
+    std::vector<std::string> level{""};
+    for (std::size_t l = 1; l <= 5; ++l) {
+      std::vector<std::string> next;
+      for (const auto &prefix : level) {
+        for (char c : {'a', 'b', 'c'}) {
+          auto pattern = prefix + c;
+          if (CSA::isEmpty(rlcsa->count(pattern))) continue;
+          next.push_back(pattern);
+          patterns.push_back(pattern);
+        }
+      }
+      level.swap(next);
+    }
+  }
+};
+
+
+TEST_P(PDLCountTest, count) {
+  ASSERT_TRUE(rlcsa->isOk());
+  ASSERT_FALSE(patterns.empty());
+
+  for (bool fast_count : {false, true}) {
+    PDLCount pdl(*rlcsa, block_size, fast_count);
+    ASSERT_TRUE(pdl.isOk());
+
+    for (const auto &pattern : patterns) {
+      auto range = rlcsa->count(pattern);
+      EXPECT_EQ(pdl.count(range), bruteForceDocCount(*rlcsa, range))
+                << "Pattern " << pattern << " [" << range.first << ", " << range.second << "], fast " << fast_count;
+      EXPECT_EQ(pdl.count(pattern), bruteForceDocCount(*rlcsa, pattern)) << "Pattern " << pattern;
+    }
+  }
+}
+
+
+TEST_P(PDLCountTest, count_any_range) {
+  // Without the shortcut of PDL-fast, any range can be counted: nodes, partial blocks and their combinations
+  PDLCount pdl(*rlcsa, block_size, false);
+  ASSERT_TRUE(pdl.isOk());
+
+  for (usint sp = 0; sp < rlcsa->getSize(); ++sp) {
+    for (usint ep = sp; ep < std::min(rlcsa->getSize(), sp + 4 * block_size); ++ep) {
+      CSA::pair_type range(sp, ep);
+      ASSERT_EQ(pdl.count(range), bruteForceDocCount(*rlcsa, range)) << "[" << sp << ", " << ep << "]";
+    }
+  }
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    PDLCount,
+    PDLCountTest,
+    ::testing::Values(
+        std::make_tuple(5, 60, 8),
+        std::make_tuple(30, 40, 16),
+        std::make_tuple(100, 20, 32)
+    )
+);
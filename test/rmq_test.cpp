@@ -0,0 +1,112 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <sdsl/int_vector.hpp>
+
+#include "drl/rmq.h"
+
+
+static_assert(drl::IsRMQ<drl::DefaultRMQ>::value, "sdsl RMQ");
+static_assert(drl::IsRMQ<drl::CompactBlockRMQ>::value, "Compact block RMQ");
+static_assert(drl::IsRMQ<drl::SIMDBlockRMQ>::value, "SIMD block RMQ");
+static_assert(!drl::IsRMQ<sdsl::int_vector<>>::value, "Not an RMQ");
+
+
+template<typename _RMQ>
+class BlockRMQTest : public ::testing::Test {
+ protected:
+  static std::size_t ExpectedRMQ(const sdsl::int_vector<> &_values, std::size_t _i, std::size_t _j) {
+    auto k = _i;
+    for (auto l = _i + 1; l <= _j; ++l) {
+      if (_values[l] < _values[k]) k = l;
+    }
+    return k;
+  }
+
+  /// Random values in [0, _sigma), so small alphabets have many ties
+  static sdsl::int_vector<> Values(std::size_t _n, std::size_t _sigma, std::size_t _seed) {
+    std::mt19937 gen(_seed);
+    sdsl::int_vector<> values(_n, 0);
+    for (auto &&v : values) v = gen() % _sigma;
+    return values;
+  }
+};
+
+using BlockRMQTypes = ::testing::Types<drl::CompactBlockRMQ,
+                                       drl::SIMDBlockRMQ,
+                                       drl::BlockRMQ<sdsl::int_vector<>, 1>,
+                                       drl::BlockRMQ<std::vector<uint32_t>, 8>,
+                                       drl::BlockRMQ<std::vector<uint32_t>, 256>>;
+TYPED_TEST_CASE(BlockRMQTest, BlockRMQTypes);
+
+
+TYPED_TEST(BlockRMQTest, all_queries) {
+  for (std::size_t n : {1, 7, 64, 65, 300}) {
+    auto values = this->Values(n, 10, n);
+    TypeParam rmq(&values);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t j = i; j < n; ++j) {
+        EXPECT_EQ(rmq(i, j), this->ExpectedRMQ(values, i, j)) << "n = " << n << " [" << i << ", " << j << "]";
+      }
+    }
+  }
+}
+
+
+TYPED_TEST(BlockRMQTest, random_queries) {
+  for (std::size_t sigma : {std::size_t(2), std::size_t(1000), std::size_t(1) << 31}) {
+    auto values = this->Values(20000, sigma, sigma);
+    TypeParam rmq(&values);
+
+    std::mt19937 gen(sigma);
+    for (std::size_t q = 0; q < 2000; ++q) {
+      std::size_t i = gen() % values.size(), j = gen() % values.size();
+      if (i > j) std::swap(i, j);
+
+      rmq.prefetch(i, j);
+      EXPECT_EQ(rmq(i, j), this->ExpectedRMQ(values, i, j));
+    }
+  }
+}
+
+
+TYPED_TEST(BlockRMQTest, serialize_and_load) {
+  auto values = this->Values(5000, 100, 3);
+  TypeParam rmq(&values);
+
+  std::stringstream ss;
+  rmq.serialize(ss);
+
+  TypeParam loaded;
+  loaded.load(ss);
+
+  EXPECT_EQ(loaded.size(), values.size());
+  std::mt19937 gen(4);
+  for (std::size_t q = 0; q < 1000; ++q) {
+    std::size_t i = gen() % values.size(), j = gen() % values.size();
+    if (i > j) std::swap(i, j);
+
+    EXPECT_EQ(loaded(i, j), this->ExpectedRMQ(values, i, j));
+  }
+}
+
+
+TEST(SIMDBlockRMQ, rejects_values_wider_than_32_bits) {
+  std::vector<uint64_t> values = {3, uint64_t(1) << 32, 1};
+  EXPECT_THROW(drl::SIMDBlockRMQ rmq(&values), std::out_of_range);
+
+  values[1] = std::numeric_limits<uint32_t>::max();
+  drl::SIMDBlockRMQ rmq(&values);
+  EXPECT_EQ(rmq(0, 1), 0);
+  EXPECT_EQ(rmq(1, 2), 2);
+}
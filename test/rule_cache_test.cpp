@@ -0,0 +1,286 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rlcsa/rlcsa.h>
+
+#include "drl/pdlrp.h"
+#include "drl/rule_cache.h"
+
+
+/// Expansion of a rule in the tests: its length depends on the rule
+std::vector<uint32_t> Expansion(std::size_t _rule, std::size_t _min_length = 16) {
+  std::vector<uint32_t> docs(_min_length + _rule % 8);
+  for (std::size_t i = 0; i < docs.size(); ++i) docs[i] = _rule * 100 + i;
+  return docs;
+}
+
+
+std::pair<bool, std::vector<uint32_t>> Report(const drl::RuleCache &_cache, std::size_t _rule) {
+  std::vector<uint32_t> docs;
+  auto report = [&docs](uint32_t _d) { docs.push_back(_d); };
+  bool found = _cache.report(_rule, report);
+  return {found, docs};
+}
+
+
+TEST(RuleCache, hits_and_misses) {
+  drl::RuleCache cache(1 << 16);
+
+  EXPECT_FALSE(Report(cache, 3).first);
+  EXPECT_EQ(cache.misses(), 1);
+
+  auto docs = Expansion(3);
+  cache.insert(3, docs.begin(), docs.end());
+  EXPECT_EQ(cache.size(), docs.size() * sizeof(uint32_t));
+
+  auto res = Report(cache, 3);
+  EXPECT_TRUE(res.first);
+  EXPECT_EQ(res.second, docs);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 1);
+}
+
+
+TEST(RuleCache, short_rules_are_not_admitted) {
+  drl::RuleCache cache(1 << 16, 16);
+
+  std::vector<uint32_t> docs(15, 7);
+  cache.insert(5, docs.begin(), docs.end());
+  EXPECT_EQ(cache.size(), 0);
+
+  // The rule is known to be short: it is not looked up, and it is not a miss
+  EXPECT_FALSE(Report(cache, 5).first);
+  EXPECT_EQ(cache.misses(), 0);
+
+  docs.push_back(7);
+  cache.insert(6, docs.begin(), docs.end());
+  EXPECT_TRUE(Report(cache, 6).first);
+  EXPECT_EQ(cache.hits(), 1);
+}
+
+
+TEST(RuleCache, capacity) {
+  const std::size_t kCapacity = 1000;
+  drl::RuleCache cache(kCapacity, 16, 1);
+
+  // Larger than the capacity
+  std::vector<uint32_t> docs(kCapacity / sizeof(uint32_t) + 1, 1);
+  cache.insert(1, docs.begin(), docs.end());
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(Report(cache, 1).first);
+
+  for (std::size_t rule = 2; rule < 100; ++rule) {
+    auto expansion = Expansion(rule);
+    cache.insert(rule, expansion.begin(), expansion.end());
+    EXPECT_LE(cache.size(), kCapacity);
+
+    // The last inserted rule is always cached
+    auto res = Report(cache, rule);
+    EXPECT_TRUE(res.first);
+    EXPECT_EQ(res.second, expansion);
+  }
+}
+
+
+TEST(RuleCache, eviction_keeps_referenced_entries) {
+  // Room for two expansions of 16 documents in a single shard
+  drl::RuleCache cache(2 * 16 * sizeof(uint32_t), 16, 1);
+
+  std::vector<uint32_t> docs(16, 1);
+  cache.insert(0, docs.begin(), docs.end());
+  cache.insert(1, docs.begin(), docs.end());
+  EXPECT_TRUE(Report(cache, 0).first);
+
+  cache.insert(2, docs.begin(), docs.end());
+  EXPECT_TRUE(Report(cache, 0).first);
+  EXPECT_FALSE(Report(cache, 1).first);
+  EXPECT_TRUE(Report(cache, 2).first);
+  EXPECT_EQ(cache.size(), 2 * 16 * sizeof(uint32_t));
+}
+
+
+TEST(RuleCache, concurrent_report_and_insert) {
+  const std::size_t kCapacity = 4096, kThreads = 8, kLookups = 5000, kRules = 200;
+  drl::RuleCache cache(kCapacity, 16, 4);
+
+  std::vector<std::thread> threads;
+  std::vector<std::size_t> wrong(kThreads, 0);
+  for (std::size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&cache, &wrong, t, kLookups, kRules]() {
+      std::mt19937 gen(t);
+      for (std::size_t i = 0; i < kLookups; ++i) {
+        auto rule = gen() % kRules;
+        auto expansion = Expansion(rule);
+        auto res = Report(cache, rule);
+        if (!res.first) cache.insert(rule, expansion.begin(), expansion.end());
+        else if (res.second != expansion) ++wrong[t];
+      }
+    });
+  }
+  for (auto &&thread : threads) thread.join();
+
+  EXPECT_EQ(wrong, std::vector<std::size_t>(kThreads, 0));
+  EXPECT_EQ(cache.hits() + cache.misses(), kThreads * kLookups);
+  EXPECT_GT(cache.hits(), 0);
+  EXPECT_LE(cache.size(), kCapacity);
+}
+
+
+/**
+ * Compress the sets written by PDLTree::writeSets into the grammar and block files read by readGrammar and
+ * readBlocks, pairing the adjacent symbols of each set level by level (a stand-in for RePair).
+ */
+void CompressSets(FILE *_sets, usint _nd, usint _nodes, const std::string &_base_name) {
+  uint terminals = _nd + 1 + _nodes;
+  std::map<std::pair<uint, uint>, uint> rules;
+  std::vector<uint> grammar, blocks, set;
+
+  uint value;
+  while (std::fread(&value, sizeof(value), 1, _sets) == 1) {
+    if (value <= _nd) {
+      set.push_back(value);
+      continue;
+    }
+
+    // Endmarker: the set is replaced by a single symbol
+    while (set.size() > 1) {
+      std::vector<uint> next;
+      for (std::size_t i = 0; i + 1 < set.size(); i += 2) {
+        auto symbol = terminals + rules.size();
+        auto res = rules.emplace(std::make_pair(set[i], set[i + 1]), symbol);
+        if (res.second) {
+          grammar.push_back(set[i]);
+          grammar.push_back(set[i + 1]);
+        }
+        next.push_back(res.first->second);
+      }
+      if (set.size() % 2) next.push_back(set.back());
+      set.swap(next);
+    }
+    blocks.insert(blocks.end(), set.begin(), set.end());
+    blocks.push_back(value);
+    set.clear();
+  }
+
+  std::ofstream grammar_file(_base_name + PDLTree::SETS_EXTENSION + ".R", std::ios_base::binary);
+  grammar_file.write((char *) &terminals, sizeof(terminals));
+  grammar_file.write((char *) grammar.data(), grammar.size() * sizeof(uint));
+
+  std::ofstream blocks_file(_base_name + PDLTree::SETS_EXTENSION + ".C", std::ios_base::binary);
+  blocks_file.write((char *) blocks.data(), blocks.size() * sizeof(uint));
+}
+
+
+/// PDL-RP index of random documents, built on an RLCSA in memory, with the sets compressed by CompressSets.
+class PDLRPRuleCacheTest : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t, std::size_t>> {
+ protected:
+  std::unique_ptr<RLCSA> rlcsa;
+  std::string base_name;
+
+  void SetUp() override {
+    auto nd = std::get<0>(GetParam());
+    auto max_len = std::get<1>(GetParam());
+    auto block_size = std::get<2>(GetParam());
+
+    std::mt19937 gen(nd * 31 + max_len);
+    std::string text;
+    for (std::size_t d = 0; d < nd; ++d) {
+      for (std::size_t i = 0, len = 1 + gen() % max_len; i < len; ++i) text.push_back('a' + gen() % 3);
+      text.push_back('\0');
+    }
+
+    auto *data = new CSA::uchar[text.size()];
+    std::copy(text.begin(), text.end(), data);
+    rlcsa.reset(new RLCSA(data, text.size(), 32, 4, 1, true));
+
+    base_name = ::testing::TempDir() + "rule_cache_test_" + std::to_string(nd) + "_" + std::to_string(block_size);
+
+    PDLTree tree(*rlcsa, block_size, 4, PDLTree::mode_rp);
+    {
+      std::ofstream output(base_name + PDLTree::EXTENSION, std::ios_base::binary);
+      tree.writeTo(output);
+    }
+
+    FILE *sets_file = std::tmpfile();
+    tree.writeSets(*sets_file);
+    std::rewind(sets_file);
+    CompressSets(sets_file, nd, tree.getNumberOfNodes(), base_name);
+    std::fclose(sets_file);
+  }
+
+  void TearDown() override {
+    std::remove((base_name + PDLTree::EXTENSION).c_str());
+    std::remove((base_name + PDLTree::SETS_EXTENSION + ".R").c_str());
+    std::remove((base_name + PDLTree::SETS_EXTENSION + ".C").c_str());
+  }
+
+  /// All the patterns of up to three letters
+  static std::vector<std::string> Patterns() {
+    std::vector<std::string> patterns{""};
+    for (std::size_t b = 0, e = 1; patterns.back().size() < 3; b = e, e = patterns.size()) {
+      for (auto i = b; i < e; ++i) {
+        for (char c : {'a', 'b', 'c'}) patterns.push_back(patterns[i] + c);
+      }
+    }
+    patterns.erase(patterns.begin());
+    return patterns;
+  }
+};
+
+
+TEST_P(PDLRPRuleCacheTest, query_with_and_without_cache) {
+  ASSERT_TRUE(rlcsa->isOk());
+
+  PDLRP pdl(*rlcsa, base_name, true);
+  ASSERT_TRUE(pdl.isOk());
+  EXPECT_EQ(pdl.getRuleCache(), nullptr);
+
+  for (usint capacity : {1u << 20, 4096u}) {
+    PDLRP pdl_cache(*rlcsa, base_name, true, false, false, false, false, capacity);
+    ASSERT_TRUE(pdl_cache.isOk());
+    ASSERT_NE(pdl_cache.getRuleCache(), nullptr);
+
+    // The second round is answered (partially) from the cache
+    for (int round = 0; round < 2; ++round) {
+      for (const auto &pattern : Patterns()) {
+        PDLRP::result_type expected, res;
+        EXPECT_EQ(pdl_cache.query(pattern, res), pdl.query(pattern, expected));
+        EXPECT_EQ(res, expected) << "Pattern " << pattern << ", capacity " << capacity;
+
+        auto range = rlcsa->count(pattern);
+        if (CSA::isEmpty(range)) continue;
+        std::unique_ptr<std::vector<uint>> brute(bruteForceDocList(*rlcsa, range));
+        std::sort(brute->begin(), brute->end());
+        brute->erase(std::unique(brute->begin(), brute->end()), brute->end());
+        EXPECT_EQ(res, *brute) << "Pattern " << pattern;
+      }
+    }
+    if (capacity == 1u << 20) {
+      EXPECT_GT(pdl_cache.getRuleCache()->hits(), 0);
+    }
+    EXPECT_LE(pdl_cache.getRuleCache()->size(), capacity);
+  }
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+    PDLRPRuleCache,
+    PDLRPRuleCacheTest,
+    ::testing::Values(
+        std::make_tuple(40, 40, 32),
+        std::make_tuple(100, 30, 64)
+    )
+);
@@ -0,0 +1,496 @@
+//
+// Created by Dustin Cobas Batista <dustin.cobas@gmail.com> on 10/17/26.
+//
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include <rlcsa/rlcsa.h>
+
+#include <sdsl/int_vector.hpp>
+
+#include <grammar/algorithm.h>
+#include <grammar/re_pair.h>
+#include <grammar/slp.h>
+#include <grammar/slp_metadata.h>
+
+#include "drl/utils.h"
+#include "drl/pdltree.h"
+#include "drl/pdl_suffix_tree.h"
+#include "drl/dl_basic_scheme.h"
+#include "drl/dl_sampled_tree_scheme.h"
+#include "drl/helper.h"
+#include "drl/dedup.h"
+
+
+DEFINE_string(data, "", "Collection file (sequences ended by '\\0'), as given to build_rlcsa.");
+DEFINE_string(patterns, "", "Pattern file (the query log).");
+DEFINE_string(block_sizes, "64,128,256,512,1024", "Candidate block sizes (comma-separated).");
+DEFINE_string(storing_factors, "2,4,8,16,32", "Candidate storing factors (comma-separated).");
+DEFINE_string(families, "pdl,cslp", "Candidate families: pdl (PDLTree + Re-Pair sets) and/or cslp (CombinedSLP + GCChunks).");
+DEFINE_double(sample_mb, 16, "Collection sample in MB: whole sequences from the start of the file (0 = all).");
+DEFINE_int32(sample_patterns, 1000, "Number of patterns taken evenly from the pattern file (0 = all).");
+DEFINE_double(budget, 0, "Space budget in bits per character of the sample (0 = no budget).");
+DEFINE_int32(repetitions, 3, "Query repetitions per candidate; the fastest one is reported.");
+DEFINE_int32(rlcsa_block_size, 32, "Block size of the RLCSA built on the sample.");
+DEFINE_int32(rlcsa_sample_rate, 128, "Sample rate of the RLCSA built on the sample.");
+DEFINE_int32(threads, 1, "Threads used to build the RLCSA on the sample.");
+
+
+/**
+ * Document sets of a PDLTree, compressed with Re-Pair as a single sequence.
+ *
+ * The sets are read from the output of PDLTree::writeSets() and concatenated without their endmarkers, as PDL-RP
+ * compresses the same sequence. The starting positions of the sets are bit-packed, and a set is decompressed by
+ * expanding its range of the grammar.
+ */
+class GrammarSets {
+ public:
+  GrammarSets(FILE *_input, usint _ndocs, grammar::RePairEncoder<true> &_encoder) : ndocs_{_ndocs} {
+    uint value = 0;
+    if (std::fread(&value, sizeof(value), 1, _input) != 1) return;  // Number of documents.
+
+    std::vector<uint32_t> docs;
+    std::vector<usint> borders(1, 0);
+    while (std::fread(&value, sizeof(value), 1, _input) == 1) {
+      if (value > ndocs_) {
+        borders.emplace_back(docs.size());  // Endmarker of the current set.
+      } else {
+        docs.emplace_back(value);  // ndocs means all documents.
+      }
+    }
+
+    sdsl::int_vector<> seq;
+    grammar::Construct(seq, docs);
+    sdsl::util::bit_compress(seq);
+    auto wrapper = BuildSLPWrapper(slp_);
+    _encoder.Encode(seq.begin(), seq.end(), wrapper);
+
+    borders_ = sdsl::int_vector<>(borders.size(), 0, CSA::length(docs.size()));
+    std::copy(borders.begin(), borders.end(), borders_.begin());
+  }
+
+  GrammarSets(const GrammarSets &) = delete;
+  GrammarSets &operator=(const GrammarSets &) = delete;
+
+  template<typename _Report>
+  void addBlocks(usint _first, usint _number, _Report &_report) const {
+    if (_first + _number >= borders_.size()) return;
+
+    bool all = false;
+    auto report = [&_report, &all, this](uint32_t _d) {
+      if (_d == ndocs_) all = true;
+      else _report(_d);
+    };
+    get_docs_(borders_[_first], borders_[_first + _number], report);
+
+    if (all) {
+      for (usint d = 0; d < ndocs_; ++d) _report(d);
+    }
+  }
+
+  usint reportSize() const {
+    return sizeof(*this) + sdsl::size_in_bytes(slp_) + sdsl::size_in_bytes(borders_);
+  }
+
+ private:
+  usint ndocs_;
+  grammar::SLP<> slp_;
+  sdsl::int_vector<> borders_;
+  drl::GetDocGCDA<grammar::SLP<>> get_docs_{slp_};
+};
+
+
+class MergeSetsLinearFunctor {
+ public:
+  template<typename _II, typename _Sets, typename _Result>
+  inline void operator()(_II _first, _II _last, const _Sets &_sets, _Result &_result) const {
+    auto report = [&_result](const auto &_value) { _result.emplace_back(_value); };
+
+    int c = 1;
+    auto prev = _first;
+    for (auto it = _first + 1; it != _last; ++it) {
+      if (*(it - 1) + 1 == *it) {
+        ++c;
+      } else {
+        _sets.addBlocks(*prev, c, report);
+        prev = it;
+        c = 1;
+      }
+    }
+    _sets.addBlocks(*prev, c, report);
+
+    drl::Dedup(_result);
+  }
+};
+
+
+class MergeSetsBinTreeFunctor {
+ public:
+  template<typename _II, typename _Sets, typename _Result>
+  inline void operator()(_II _first, _II _last, const _Sets &_sets, _Result &_result) const {
+    grammar::MergeSetsBinaryTree(_first, _last, _sets, _result);
+  }
+};
+
+
+struct Candidate {
+  std::string family;
+  usint block_size;
+  usint storing_factor;
+  usint bytes;
+  double bpc;
+  double micros;  // Per pattern
+  usint docs;
+  bool valid;  // Reported the expected documents for every pattern
+  bool pareto;
+};
+
+
+std::vector<usint> ParseList(const std::string &_list) {
+  std::vector<usint> values;
+  std::stringstream ss(_list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) values.emplace_back(std::stoul(item));
+  }
+  return values;
+}
+
+
+/**
+ * Read whole sequences from the start of the collection until _bytes bytes (0 = all).
+ *
+ * @return Buffer with the sequences ended by '\0'; the caller must delete it
+ */
+CSA::uchar *ReadSample(const std::string &_file, usint _bytes, usint &_size) {
+  std::ifstream input(_file, std::ios_base::binary);
+  if (!input) return nullptr;
+
+  std::string sample;
+  std::string sequence;
+  while ((_bytes == 0 || sample.size() < _bytes) && std::getline(input, sequence, '\0')) {
+    sample += sequence;
+    sample.push_back('\0');
+  }
+
+  _size = sample.size();
+  if (_size == 0) return nullptr;
+
+  auto *data = new CSA::uchar[_size];
+  std::copy(sample.begin(), sample.end(), data);
+  return data;
+}
+
+
+/**
+ * Run the queries _repetitions times and return the fastest time in seconds.
+ */
+template<typename _Index>
+double TimeQueries(const _Index &_idx, const std::vector<CSA::pair_type> &_ranges, usint &_docs) {
+  double best = 0;
+  for (int r = 0; r < std::max(FLAGS_repetitions, 1); ++r) {
+    usint docs = 0;
+    double start = CSA::readTimer();
+    for (const auto &range : _ranges) {
+      auto res = _idx.list(range.first, range.second + 1);
+      docs += res.size();
+    }
+    double seconds = CSA::readTimer() - start;
+
+    if (r == 0 || seconds < best) best = seconds;
+    _docs = docs;
+  }
+  return best;
+}
+
+
+/**
+ * Check the documents reported for each range against the expected ones (sorted and without repetitions).
+ *
+ * @return Index of the first range with wrong documents, or the number of ranges if every range is right
+ */
+template<typename _Index>
+std::size_t ValidateQueries(const _Index &_idx,
+                            const std::vector<CSA::pair_type> &_ranges,
+                            const std::vector<std::vector<uint>> &_expected) {
+  std::vector<uint> docs;
+  for (std::size_t i = 0; i < _ranges.size(); ++i) {
+    auto res = _idx.list(_ranges[i].first, _ranges[i].second + 1);
+    docs.assign(res.begin(), res.end());
+    std::sort(docs.begin(), docs.end());
+    if (docs != _expected[i]) return i;
+  }
+  return _ranges.size();
+}
+
+
+/**
+ * Mark the valid candidates not dominated by another valid one (smaller or equal size and faster).
+ */
+void ComputeParetoFrontier(std::vector<Candidate> &_candidates) {
+  std::vector<std::size_t> order;
+  for (std::size_t i = 0; i < _candidates.size(); ++i) {
+    _candidates[i].pareto = false;
+    if (_candidates[i].valid) order.emplace_back(i);
+  }
+  std::sort(order.begin(), order.end(), [&_candidates](auto _a, auto _b) {
+    const auto &a = _candidates[_a];
+    const auto &b = _candidates[_b];
+    return a.bytes < b.bytes || (a.bytes == b.bytes && a.micros < b.micros);
+  });
+
+  bool first = true;
+  double best = 0;
+  for (auto i : order) {
+    auto &c = _candidates[i];
+    c.pareto = first || c.micros < best;
+    if (c.pareto) best = c.micros;
+    first = false;
+  }
+}
+
+
+void PrintCandidate(const Candidate &_c) {
+  std::cout << _c.family << "," << _c.block_size << "," << _c.storing_factor << "," << _c.bytes << ","
+            << std::fixed << std::setprecision(3) << _c.bpc << "," << _c.micros << "," << _c.docs << ","
+            << (_c.valid ? 1 : 0) << "," << (_c.pareto ? 1 : 0) << std::endl;
+}
+
+
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  if (FLAGS_data.empty() || FLAGS_patterns.empty()) {
+    std::cerr << "Input Error!!!" << std::endl;
+    return 1;
+  }
+
+  auto block_sizes = ParseList(FLAGS_block_sizes);
+  auto storing_factors = ParseList(FLAGS_storing_factors);
+  bool tune_pdl = FLAGS_families.find("pdl") != std::string::npos;
+  bool tune_cslp = FLAGS_families.find("cslp") != std::string::npos;
+
+
+  // Collection sample
+  usint sample_size = 0;
+  auto *sample = ReadSample(FLAGS_data, FLAGS_sample_mb * CSA::MEGABYTE, sample_size);
+  if (sample == nullptr) {
+    std::cerr << "Error reading collection!" << std::endl;
+    return 2;
+  }
+
+  auto rlcsa = std::make_shared<CSA::RLCSA>(sample,
+                                            sample_size,
+                                            FLAGS_rlcsa_block_size,
+                                            FLAGS_rlcsa_sample_rate,
+                                            FLAGS_threads,
+                                            true);
+  if (!(rlcsa->isOk())) {
+    std::cerr << "Error building the RLCSA of the sample!" << std::endl;
+    return 2;
+  }
+  const auto kNDocs = rlcsa->getNumberOfSequences();
+  std::cout << "Sample:       " << sample_size << " bytes, " << kNDocs << " sequences" << std::endl;
+
+
+  // Pattern sample
+  std::vector<std::string> rows;
+  {
+    std::ifstream pattern_file(FLAGS_patterns.c_str(), std::ios_base::binary);
+    if (!pattern_file) {
+      std::cerr << "Error opening pattern file!" << std::endl;
+      return 3;
+    }
+    CSA::readRows(pattern_file, rows, true);
+    pattern_file.close();
+  }
+
+  usint step = 1;
+  if (FLAGS_sample_patterns > 0 && rows.size() > static_cast<usint>(FLAGS_sample_patterns)) {
+    step = rows.size() / FLAGS_sample_patterns;
+  }
+
+  // Only the patterns occurring in the sample are queried; their reference lists validate the candidates.
+  std::vector<CSA::pair_type> ranges;
+  std::vector<std::string> patterns;
+  std::vector<std::vector<uint>> expected;
+  for (usint i = 0; i < rows.size(); i += step) {
+    if (FLAGS_sample_patterns > 0 && ranges.size() == static_cast<usint>(FLAGS_sample_patterns)) break;
+
+    auto range = rlcsa->count(rows[i]);
+    if (CSA::isEmpty(range) || range.second >= rlcsa->getSize()) continue;
+
+    ranges.emplace_back(range);
+    patterns.emplace_back(rows[i]);
+    std::unique_ptr<std::vector<uint>> docs(bruteForceDocList(*rlcsa, range));
+    drl::Dedup(*docs);
+    expected.emplace_back(std::move(*docs));
+  }
+  std::cout << "Patterns:     " << ranges.size() << " occurring in the sample (of " << rows.size() << ")" << std::endl;
+  if (ranges.empty()) {
+    std::cerr << "No sampled pattern occurs in the sample!" << std::endl;
+    return 3;
+  }
+
+  drl::GetDocRLCSA get_doc_rlcsa(rlcsa);
+  MergeSetsLinearFunctor merge_linear;
+  MergeSetsBinTreeFunctor merge_bin_tree;
+
+  std::vector<Candidate> candidates;
+  auto add_candidate = [&](const std::string &_family,
+                           usint _bs,
+                           usint _sf,
+                           usint _bytes,
+                           double _seconds,
+                           usint _docs,
+                           std::size_t _wrong) {
+    Candidate c{_family, _bs, _sf, _bytes, 8.0 * _bytes / sample_size, 1000000.0 * _seconds / ranges.size(), _docs,
+                _wrong == ranges.size(), false};
+    if (!c.valid) {
+      std::cerr << "Error: " << _family << " " << _bs << "/" << _sf << " reported wrong documents for pattern \""
+                << patterns[_wrong] << "\"; the candidate is excluded" << std::endl;
+    }
+    std::cerr << _family << " bs=" << _bs << " sf=" << _sf << ": " << c.bpc << " bpc, " << c.micros << " us/pattern"
+              << std::endl;
+    candidates.emplace_back(c);
+  };
+
+
+  // PDLTree candidates
+  if (tune_pdl) {
+    grammar::RePairEncoder<true> encoder_sets;
+
+    for (auto bs : block_sizes) {
+      for (auto sf : storing_factors) {
+        PDLTree tree(*rlcsa, bs, sf, PDLTree::mode_set);
+        if (!(tree.isOk())) {
+          std::cerr << "Error building PDLTree " << bs << "/" << sf << std::endl;
+          continue;
+        }
+
+        FILE *sets_file = std::tmpfile();
+        if (sets_file == nullptr) {
+          std::cerr << "Error creating temporary file!" << std::endl;
+          return 4;
+        }
+        tree.writeSets(*sets_file);
+        std::rewind(sets_file);
+        GrammarSets sets(sets_file, kNDocs, encoder_sets);
+        std::fclose(sets_file);
+        tree.deleteNodes();
+
+        auto compute_cover = drl::BuildComputeCoverSuffixTreeFunctor(tree);
+        auto dl = drl::BuildDLSampledTreeScheme(compute_cover, get_doc_rlcsa, sets, merge_linear);
+
+        usint docs = 0;
+        double seconds = TimeQueries(dl, ranges, docs);
+        add_candidate("pdl", bs, sf, tree.reportSize() + sets.reportSize(), seconds, docs,
+                      ValidateQueries(dl, ranges, expected));
+      }
+    }
+  }
+
+
+  // CombinedSLP candidates
+  if (tune_cslp) {
+    sdsl::int_vector<> da;
+    {
+      std::vector<uint32_t> doc_array(rlcsa->getSize());
+      usint *positions = rlcsa->locate(CSA::pair_type(0, rlcsa->getSize() - 1));
+      rlcsa->getSequenceForPosition(positions, rlcsa->getSize());
+      std::copy(positions, positions + rlcsa->getSize(), doc_array.begin());
+      delete[] positions;
+
+      grammar::Construct(da, doc_array);
+      sdsl::util::bit_compress(da);
+    }
+
+    grammar::RePairEncoder<true> encoder;
+    grammar::RePairEncoder<false> encoder_nslp;
+
+    for (auto bs : block_sizes) {
+      for (auto sf : storing_factors) {
+        grammar::CombinedSLP<> cslp;
+        grammar::Chunks<> cslp_chunks;
+        {
+          auto wrapper = BuildSLPWrapper(cslp);
+          encoder.Encode(da.begin(), da.end(), wrapper);
+
+          grammar::AddSet<decltype(cslp_chunks)> add_set(cslp_chunks);
+          cslp.Compute(bs, add_set, add_set, grammar::MustBeSampled<decltype(cslp_chunks)>(
+              grammar::AreChildrenTooBig<decltype(cslp_chunks)>(cslp_chunks, sf)));
+        }
+
+        grammar::GCChunks<grammar::SLP<>> gcchunks;
+        const auto &objs = cslp_chunks.GetObjects();
+        gcchunks.Compute(objs.begin(), objs.end(), cslp_chunks, encoder_nslp);
+
+        auto compute_cover = drl::BuildComputeCoverBottomFunctor(cslp);
+        drl::ExpandSLPCoverFunctor<grammar::CombinedSLP<>> slp_get_docs{cslp};
+        auto dl = drl::BuildDLSampledTreeScheme(compute_cover, slp_get_docs, gcchunks, merge_bin_tree);
+
+        usint docs = 0;
+        double seconds = TimeQueries(dl, ranges, docs);
+        add_candidate("cslp", bs, sf, sdsl::size_in_bytes(cslp) + sdsl::size_in_bytes(gcchunks), seconds, docs,
+                      ValidateQueries(dl, ranges, expected));
+      }
+    }
+  }
+
+  if (candidates.empty()) {
+    std::cerr << "No candidate was built!" << std::endl;
+    return 4;
+  }
+  if (std::none_of(candidates.begin(), candidates.end(), [](const auto &_c) { return _c.valid; })) {
+    std::cerr << "No candidate reported the expected documents!" << std::endl;
+    return 4;
+  }
+
+
+  // Results
+  ComputeParetoFrontier(candidates);
+
+  std::cout << std::endl;
+  std::cout << "family,block_size,storing_factor,bytes,bpc,us_per_pattern,docs,valid,pareto" << std::endl;
+  for (const auto &c : candidates) {
+    PrintCandidate(c);
+  }
+
+  std::vector<Candidate> frontier;
+  std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(frontier), [](const auto &_c) {
+    return _c.pareto;
+  });
+  std::sort(frontier.begin(), frontier.end(), [](const auto &_a, const auto &_b) { return _a.bytes < _b.bytes; });
+
+  std::cout << std::endl << "Pareto frontier" << std::endl;
+  for (const auto &c : frontier) {
+    PrintCandidate(c);
+  }
+
+  // The frontier is sorted by size and its times decrease, so the largest candidate within the budget is the fastest.
+  auto recommended = frontier.begin();
+  for (auto it = frontier.begin(); it != frontier.end(); ++it) {
+    if (FLAGS_budget <= 0 || it->bpc <= FLAGS_budget) recommended = it;
+  }
+
+  std::cout << std::endl;
+  if (FLAGS_budget > 0 && recommended->bpc > FLAGS_budget) {
+    std::cout << "No candidate fits in " << FLAGS_budget << " bpc; the smallest one is" << std::endl;
+  } else {
+    std::cout << "Recommended" << std::endl;
+  }
+  PrintCandidate(*recommended);
+  std::cout << "--bs " << recommended->block_size << " --sf " << recommended->storing_factor << std::endl;
+
+  return 0;
+}